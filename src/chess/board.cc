@@ -1,6 +1,7 @@
 #include "board.h"
 
 #include "../engine/evaluation/nnue/accumulator.h"
+#include "../utils/timers.h"
 #include "fen.h"
 #include "move.h"
 #include "move_gen.h"
@@ -18,19 +19,36 @@ constexpr std::array<U8, 64> kCastlingRights = {
 };
 // clang-format on
 
-Board::Board() : history_({}) {}
+Board::Board(BoardMode mode) : mode_(mode), history_({}) {}
 
-Board::Board(const BoardState &state) : history_({}), state_(state) {}
+Board::Board(const BoardState &state, BoardMode mode)
+    : mode_(mode), history_({}) {
+  SetFromState(state);
+}
 
 void Board::SetFromFen(std::string_view fen_str) {
-  state_ = fen::StringToBoard(fen_str);
+  SetFromState(fen::StringToBoard(fen_str));
+}
+
+void Board::SetFromState(const BoardState &state) {
+  state_ = state;
 
-  accumulator_ = std::make_shared<nnue::Accumulator>();
-  accumulator_->SetFromState(state_);
+  // The accumulator is only allocated once per board and refreshed afterward
+  if (mode_ == BoardMode::kEvaluation) {
+    if (!accumulator_) {
+      accumulator_ = std::make_shared<nnue::Accumulator>();
+    }
+    accumulator_->SetFromState(state_);
+  }
 
   history_.Clear();
 
-  CalculateThreats();
+  CalculateKingThreats();
+}
+
+void Board::CopyFrom(const Board &other) {
+  SetFromState(other.state_);
+  history_ = other.history_;
 }
 
 bool Board::IsMovePseudoLegal(Move move) {
@@ -121,10 +139,29 @@ bool Board::IsMoveLegal(Move move) {
   if (piece_type == PieceType::kKing) {
     constexpr int kKingsideCastleDist = -2;
     constexpr int kQueensideCastleDist = 2;
+    constexpr BitBoard kWhiteKingsidePath = 0x60;
+    constexpr BitBoard kWhiteQueensidePath = 0xc;
+    constexpr BitBoard kBlackKingsidePath = 0x6000000000000000;
+    constexpr BitBoard kBlackQueensidePath = 0xc00000000000000;
 
     // Note: the only way move_dist is ever 2 or -2 is from
     // move_gen::CastlingMoves allowing it
     const int move_dist = static_cast<int>(from) - static_cast<int>(to);
+
+    // When the threats have already been computed for this position and we
+    // aren't in check, no slider can xray through the king, so they are
+    // exact for every square the king can move to
+    if (state_.threats && !state_.checkers) {
+      if (move_dist == kKingsideCastleDist) {
+        return !(state_.threats & (is_white ? kWhiteKingsidePath
+                                            : kBlackKingsidePath));
+      } else if (move_dist == kQueensideCastleDist) {
+        return !(state_.threats & (is_white ? kWhiteQueensidePath
+                                            : kBlackQueensidePath));
+      }
+      return !state_.threats.IsSet(to);
+    }
+
     if (move_dist == kKingsideCastleDist) {
       return !move_gen::GetAttackersTo(
                  state_, is_white ? Squares::kG1 : Squares::kG8, them) &&
@@ -182,9 +219,14 @@ bool Board::IsMoveLegal(Move move) {
   return move_gen::RayBetween(king_square, checking_piece).IsSet(to);
 }
 
+template <bool update_accumulator>
 void Board::MakeMove(Move move) {
+  SCOPED_TIMER(kBoardMakeMove);
+
   history_.Push(state_);
-  accumulator_->MakeMove(state_, move);
+  if constexpr (update_accumulator) {
+    if (accumulator_) accumulator_->MakeMove(state_, move);
+  }
 
   const Color us = state_.turn, them = FlipColor(us);
 
@@ -239,21 +281,30 @@ void Board::MakeMove(Move move) {
   state_.fifty_moves_clock = new_fifty_move_clock;
   ++state_.half_moves;
 
-  CalculateThreats();
+  state_.threats = 0;
+  CalculateKingThreats();
 }
 
+template void Board::MakeMove<true>(Move move);
+template void Board::MakeMove<false>(Move move);
+
+template <bool update_accumulator>
 void Board::UndoMove() {
   state_ = history_.PopBack();
-  accumulator_->UndoMove();
+  if constexpr (update_accumulator) {
+    if (accumulator_) accumulator_->UndoMove();
+  }
 }
 
+template void Board::UndoMove<true>();
+template void Board::UndoMove<false>();
+
 void Board::UndoNullMove() {
   state_ = history_.PopBack();
 }
 
 void Board::MakeNullMove() {
   history_.Push(state_);
-  accumulator_->MakeMove(state_, Move::NullMove());
 
   // Xor out en passant if it exists
   if (state_.en_passant != Squares::kNoSquare) {
@@ -266,7 +317,10 @@ void Board::MakeNullMove() {
 
   state_.fifty_moves_clock++;
 
-  CalculateThreats();
+  // The pieces are unchanged, so only the side to move's king needs to be
+  // looked at again
+  state_.threats = 0;
+  CalculateKingThreats();
 }
 
 U64 Board::PredictKeyAfter(Move move) {
@@ -397,6 +451,8 @@ void Board::HandleCastling(Move move) {
 }
 
 void Board::CalculateThreats() {
+  SCOPED_TIMER(kCalculateThreats);
+
   const Color them = FlipColor(state_.turn);
 
   state_.threats = move_gen::PawnAttacks(state_.Pawns(them), them);
@@ -417,8 +473,13 @@ void Board::CalculateThreats() {
   }
 
   state_.threats |= move_gen::KingAttacks(state_.King(them).GetLsb());
+}
 
-  CalculateKingThreats();
+BitBoard Board::GetThreats() {
+  if (!state_.threats) {
+    CalculateThreats();
+  }
+  return state_.threats;
 }
 
 void Board::CalculateKingThreats() {
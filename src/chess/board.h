@@ -91,6 +91,7 @@ struct BoardState {
         pawn_key(0ULL),
         non_pawn_keys({}),
         checkers(0ULL),
+        threats(0ULL),
         pinned(0ULL),
         half_moves(0) {
     piece_on_square.fill(PieceType::kNone);
@@ -238,15 +239,29 @@ struct BoardState {
   U64 zobrist_key, pawn_key;
   std::array<U64, 2> non_pawn_keys;
   BitBoard checkers;
+  // Squares attacked by the opponent, computed lazily through
+  // Board::GetThreats() since most nodes never read them. The opponent's king
+  // always attacks at least one square, so an empty mask marks it as stale
   BitBoard threats;
   BitBoard pinned;
 };
 
+enum class BoardMode {
+  // Keeps an NNUE accumulator in sync with the position for evaluation
+  kEvaluation,
+  // Never allocates or updates an accumulator, for workloads that only make
+  // moves such as perft, opening generation and FEN conversion
+  kMovesOnly,
+};
+
 class Board {
  public:
-  Board();
+  explicit Board(BoardMode mode = BoardMode::kEvaluation);
 
-  Board(const BoardState &state);
+  // Boards built straight from a state are mostly scratch boards for move
+  // generation, so they skip the accumulator unless asked for one
+  explicit Board(const BoardState &state,
+                 BoardMode mode = BoardMode::kMovesOnly);
 
   inline BoardState &GetState() {
     return state_;
@@ -258,10 +273,24 @@ class Board {
 
   void SetFromFen(std::string_view fen_str);
 
+  void SetFromState(const BoardState &state);
+
+  // Copies the position and move history of another board while keeping this
+  // board's own accumulator, so that boards never share one between threads
+  void CopyFrom(const Board &other);
+
+  [[nodiscard]] BoardMode GetMode() const {
+    return mode_;
+  }
+
+  // Workloads that never evaluate, such as perft, can skip the NNUE
+  // accumulator updates by passing false
+  template <bool update_accumulator = true>
   void MakeMove(Move move);
 
   void MakeNullMove();
 
+  template <bool update_accumulator = true>
   void UndoMove();
 
   void UndoNullMove();
@@ -278,6 +307,8 @@ class Board {
 
   [[nodiscard]] bool IsDraw(U16 ply);
 
+  [[nodiscard]] BitBoard GetThreats();
+
   void CalculateKingThreats();
 
   void CalculateThreats();
@@ -286,6 +317,7 @@ class Board {
   void HandleCastling(Move move);
 
  private:
+  BoardMode mode_;
   BoardState state_;
   List<BoardState, 1024> history_;
   std::shared_ptr<nnue::Accumulator> accumulator_;
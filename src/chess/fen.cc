@@ -4,8 +4,8 @@ namespace fen {
 
 // clang-format off
 constexpr std::array<std::array<char, kNumPieceTypes + 1>, 2> kPieceToChar = {{
-  {'p', 'n', 'b', 'r', 'q', 'k', 'x'},
-  {'P', 'N', 'B', 'R', 'Q', 'K', 'x'}
+  {'P', 'N', 'B', 'R', 'Q', 'K', 'x'},
+  {'p', 'n', 'b', 'r', 'q', 'k', 'x'}
 }};
 // clang-format on
 
@@ -230,16 +230,24 @@ BitBoard KnightMoves(Square square) {
   return kKnightMasks[square];
 }
 
+// Slider attacks are looked up through the dense PEXT tables on BMI2 capable
+// builds, and through the magic multiply-shift tables everywhere else
 BitBoard BishopMoves(Square square, const BitBoard &occupied) {
-  const auto &entry = magics::kBishopMagics[square];
-  const auto magic_index = (occupied & entry.mask) * entry.magic >> entry.shift;
-  return magics::attacks::kBishopAttacks[square][magic_index.AsU64()];
+#ifdef INTEGRAL_PEXT_ATTACKS
+  return magics::attacks::BishopPextAttacks(square, occupied);
+#else
+  return magics::attacks::BishopMagicAttacks(
+      square, occupied, magics::attacks::kBishopAttacks);
+#endif
 }
 
 BitBoard RookMoves(Square square, const BitBoard &occupied) {
-  const auto &entry = magics::kRookMagics[square];
-  const auto magic_index = (occupied & entry.mask) * entry.magic >> entry.shift;
-  return magics::attacks::kRookAttacks[square][magic_index.AsU64()];
+#ifdef INTEGRAL_PEXT_ATTACKS
+  return magics::attacks::RookPextAttacks(square, occupied);
+#else
+  return magics::attacks::RookMagicAttacks(
+      square, occupied, magics::attacks::kRookAttacks);
+#endif
 }
 
 BitBoard QueenMoves(Square square, const BitBoard &occupied) {
@@ -598,4 +606,132 @@ MoveList GenerateMoves(MoveGenType move_type, Board &board) {
   return move_list;
 }
 
+MoveList GenerateLegalMoves(MoveGenType move_type, Board &board) {
+  MoveList move_list;
+  auto &state = board.GetState();
+
+  const Color us = state.turn, them = FlipColor(us);
+  const BitBoard occupied = state.Occupied();
+  const BitBoard &their_pieces = state.Occupied(them);
+
+  const BitBoard king_mask = state.King(us);
+  const Square king_square = king_mask.GetLsb();
+
+  BitBoard targets = 0;
+  if (move_type & MoveGenType::kQuiet) targets |= ~occupied;
+  if (move_type & MoveGenType::kNoisy) targets |= their_pieces;
+
+  // The cached threats are exact for the king's destinations when we aren't in
+  // check, otherwise look at the attackers with the king lifted off the board
+  // so it can't step backwards along the ray it's being checked on
+  const bool use_threats = state.threats && !state.checkers;
+  const BitBoard kingless_occupied = occupied ^ king_mask;
+  const auto is_attacked = [&](Square square) {
+    return use_threats
+             ? state.threats.IsSet(square)
+             : GetAttackersTo(state, square, kingless_occupied, them) != 0;
+  };
+
+  const auto add_king_moves = [&]() {
+    for (Square to : KingAttacks(king_square) & targets) {
+      if (!is_attacked(to)) {
+        move_list.Push(Move(king_square, to));
+      }
+    }
+
+    if ((move_type & MoveGenType::kQuiet) && !state.checkers &&
+        state.castle_rights.CanCastle(us)) {
+      for (Square to : CastlingMoves(us, state)) {
+        // Both the square the king passes through and its destination must be
+        // safe
+        const BitBoard path =
+            RayBetween(king_square, to) | BitBoard::FromSquare(to);
+        bool safe = true;
+        for (Square square : path) {
+          safe &= !is_attacked(square);
+        }
+
+        if (safe) {
+          move_list.Push(Move(king_square, to, MoveType::kCastle));
+        }
+      }
+    }
+  };
+
+  // Only king moves are legal if there's multiple pieces checking the king
+  if (state.checkers.MoreThanOne()) {
+    add_king_moves();
+    return move_list;
+  }
+
+  // When in check, every non-king move must capture the checking piece or
+  // block its path
+  BitBoard check_mask = ~BitBoard(0);
+  if (state.checkers) {
+    const Square checker = state.checkers.GetLsb();
+    check_mask = RayBetween(king_square, checker) | state.checkers;
+  }
+
+  // Pinned pieces may only move along the ray between the pinner and our king
+  const auto pin_mask = [&](Square from) {
+    return state.pinned.IsSet(from) ? RayIntersecting(king_square, from)
+                                    : ~BitBoard(0);
+  };
+
+  MoveList pawn_moves;
+  AddPawnMoves(board, move_type, pawn_moves);
+  for (int i = 0; i < pawn_moves.Size(); i++) {
+    const auto move = pawn_moves[i];
+    const auto from = move.GetFrom(), to = move.GetTo();
+
+    if (move.GetType() == MoveType::kEnPassant) {
+      // The captured pawn and the moving pawn both leave the same rank, so
+      // verify directly that no slider sees our king after the capture
+      const BitBoard captured_pawn =
+          BitBoard::FromSquare(us == Color::kWhite ? to - 8 : to + 8);
+      const BitBoard occupied_after = occupied ^ captured_pawn ^
+                                      BitBoard::FromSquare(from) ^
+                                      BitBoard::FromSquare(to);
+      if (!GetSlidingAttackersTo(state, king_square, occupied_after, them)) {
+        move_list.Push(move);
+      }
+    } else if ((check_mask & pin_mask(from)).IsSet(to)) {
+      move_list.Push(move);
+    }
+  }
+
+  const BitBoard piece_targets = targets & check_mask;
+
+  for (Square from : state.Knights(us) & ~state.pinned) {
+    for (Square to : KnightMoves(from) & piece_targets) {
+      move_list.Push(Move(from, to));
+    }
+  }
+
+  for (Square from : state.Bishops(us)) {
+    for (Square to :
+         BishopMoves(from, occupied) & piece_targets & pin_mask(from)) {
+      move_list.Push(Move(from, to));
+    }
+  }
+
+  for (Square from : state.Rooks(us)) {
+    for (Square to :
+         RookMoves(from, occupied) & piece_targets & pin_mask(from)) {
+      move_list.Push(Move(from, to));
+    }
+  }
+
+  for (Square from : state.Queens(us)) {
+    for (Square to :
+         QueenMoves(from, occupied) & piece_targets & pin_mask(from)) {
+      move_list.Push(Move(from, to));
+    }
+  }
+
+  add_king_moves();
+
+  return move_list;
+}
+
 }  // namespace move_gen
\ No newline at end of file
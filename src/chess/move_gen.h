@@ -58,6 +58,10 @@ BitBoard RayIntersecting(Square first, Square second);
 
 MoveList GenerateMoves(MoveGenType move_type, Board &board);
 
+// Generates only fully legal moves by masking with the checkers and pinned
+// pieces of the position, so callers don't need Board::IsMoveLegal
+MoveList GenerateLegalMoves(MoveGenType move_type, Board &board);
+
 }  // namespace move_gen
 
 #endif  // INTEGRAL_MOVE_GEN_H_
\ No newline at end of file
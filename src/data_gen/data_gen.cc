@@ -6,29 +6,28 @@
 #include <csignal>
 #include <filesystem>
 #include <fstream>
+#include <random>
+
+#if defined(__unix__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #include "../chess/board.h"
 #include "../engine/search/search.h"
 #include "format/binpack.h"
+#include "format/binpack_reader.h"
+#include "format/compressed_binpack.h"
 #include "format/fens.h"
+#include "game_writer.h"
 
 namespace data_gen {
 
 MoveList GetLegalMoves(Board &board) {
-  auto move_list = move_gen::GenerateMoves(MoveGenType::kAll, board);
-  auto legal_move_list = MoveList{};
-
-  for (int i = 0; i < move_list.Size(); i++) {
-    const auto move = move_list[i];
-    if (board.IsMoveLegal(move)) {
-      legal_move_list.Push(move);
-    }
-  }
-
-  return legal_move_list;
+  return move_gen::GenerateLegalMoves(MoveGenType::kAll, board);
 }
 
-void FindStartingPosition(Board &board, I32 min_plies, I32 max_plies) {
+void PlayRandomOpening(Board &board, I32 min_plies, I32 max_plies) {
   board.SetFromFen(fen::kStartFen);
 
   I32 current_ply = 0, target_plies = RandomU64(min_plies, max_plies);
@@ -95,7 +94,21 @@ void FindStartingPosition(Board &board, I32 min_plies, I32 max_plies) {
   }
 }
 
+void FindStartingPosition(Board &board, I32 min_plies, I32 max_plies) {
+  // The random opening is played out without touching the search board's
+  // accumulator, which then only gets refreshed once from the final position
+  thread_local Board opening_board(BoardMode::kMovesOnly);
+  PlayRandomOpening(opening_board, min_plies, max_plies);
+  board.SetFromState(opening_board.GetState());
+}
+
 std::atomic<U64> positions_written = 0, games_completed = 0, start_time = 0;
+// Games are claimed one at a time from a shared count, so faster threads keep
+// playing until the whole target is reached
+std::atomic<U64> games_claimed = 0;
+// Games and positions already in the output file when a run is resumed, which
+// are left out of the speed estimates
+U64 games_resumed = 0, positions_resumed = 0;
 std::mutex display_mutex;
 
 void PrintProgress(const Config &config, U64 completed, U64 written) {
@@ -104,7 +117,8 @@ void PrintProgress(const Config &config, U64 completed, U64 written) {
   auto current_time = search::GetCurrentTime();
   auto elapsed_time = current_time - start_time;
   auto games_left = config.num_games - completed;
-  auto time_per_game = elapsed_time / std::max<U64>(1, completed);
+  auto time_per_game =
+      elapsed_time / std::max<U64>(1, completed - games_resumed);
   auto time_remaining = time_per_game * games_left;
 
   // Calculate progress bar
@@ -123,9 +137,10 @@ void PrintProgress(const Config &config, U64 completed, U64 written) {
 
   // Calculate speeds
   double games_per_second =
-      static_cast<double>(completed) / (elapsed_time / 1000.0);
+      static_cast<double>(completed - games_resumed) / (elapsed_time / 1000.0);
   double positions_per_second =
-      static_cast<double>(written) / (elapsed_time / 1000.0);
+      static_cast<double>(written - positions_resumed) /
+      (elapsed_time / 1000.0);
 
   // Format time remaining
   std::string time_str;
@@ -170,110 +185,201 @@ void PrintProgress(const Config &config, U64 completed, U64 written) {
   std::cout.flush();
 }
 
-void GameLoop(const Config &config,
-              int thread_id,
-              std::ostream &output_stream) {
-  RandomSeed(thread_id, search::GetCurrentTime());
+// A game being played by a datagen thread, which may have several of them in
+// flight at once
+struct GameSlot {
+  GameSlot()
+      : thread(std::make_unique<search::Thread>(0)), formatter(game_stream) {}
+
+  std::unique_ptr<search::Thread> thread;
+  // Each game is encoded into memory and handed to the writer whole
+  std::ostringstream game_stream;
+  format::BinPackFormatter formatter;
+  U64 win_plies = 0, loss_plies = 0, draw_plies = 0;
+  bool active = false;
+};
+
+// Claims one of the games left to play. The count never goes past the target,
+// so a claim that fails can't hide a game that is given back afterwards
+bool ClaimGame(U64 num_games) {
+  U64 claimed = games_claimed.load(std::memory_order_relaxed);
+  while (claimed < num_games) {
+    if (games_claimed.compare_exchange_weak(
+            claimed, claimed + 1, std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Claims a game and sets the slot up to play it from a random opening that
+// isn't already decided, returning false once every game has been claimed
+bool StartGame(const Config &config, search::Search &search, GameSlot &slot) {
+  auto &thread = slot.thread;
+  while (!stop && ClaimGame(config.num_games)) {
+    // Find a valid legal position to play the game from
+    FindStartingPosition(
+        thread->board, config.min_move_plies, config.max_move_plies);
+    slot.formatter.SetPosition(thread->board.GetState());
+
+    // Every search ages the table, so entries left over from the previous game
+    // are replaced first even when it isn't cleared. The other games in flight
+    // are still being searched with it, so it's only cleared when the thread
+    // plays one game at a time. The pawn cache is shared by every thread, so
+    // it's never cleared here
+    search.NewGame(false);
+    if (config.clear_tt && config.games_in_flight == 1) {
+      search.ClearHash();
+    }
+    if (config.clear_history) {
+      thread->NewGame();
+    }
+
+    const auto [initial_score, _] = search.DataGenStart(
+        thread,
+        search::TimeConfig{.depth = 10, .nodes = config.verification_nodes});
+
+    // Give the claim back, since no game was played from this position
+    if (std::abs(initial_score) >= config.max_opening_score) {
+      games_claimed.fetch_sub(1, std::memory_order_relaxed);
+      continue;
+    }
+
+    slot.win_plies = slot.loss_plies = slot.draw_plies = 0;
+    return true;
+  }
+
+  return false;
+}
 
+// Searches and plays the next move of the slot's game, returning the outcome
+// once the game is over
+std::optional<double> PlayMove(const Config &config,
+                               search::Search &search,
+                               GameSlot &slot) {
   constexpr int kWinThreshold = 1500;
   constexpr int kWinPliesThreshold = 5;
   constexpr int kDrawThreshold = 2;
   constexpr int kDrawPliesThreshold = 10;
-  constexpr int kInitialScoreThreshold = 1000;
-
-  search::TimeConfig time_config{.nodes = config.hard_node_limit,
-                                 .soft_nodes = config.soft_node_limit};
-  format::BinPackFormatter formatter(output_stream);
-
-  auto thread = std::make_unique<search::Thread>(0);
-
-  search::Search search(thread->board);
-  search.ResizeHash(16);
 
-  const int workload = config.num_games / config.num_threads;
-  for (int i = 0; i < workload && !stop; i++) {
-    // Find a valid legal position to play the game from
-    FindStartingPosition(
-        thread->board, config.min_move_plies, config.max_move_plies);
+  auto &board = slot.thread->board;
+  const auto &state = board.GetState();
 
-    const auto &state = thread->board.GetState();
-    formatter.SetPosition(state);
+  // Score returned as white-relative
+  const auto [score, best_move] = search.DataGenStart(
+      slot.thread,
+      search::TimeConfig{.nodes = config.hard_node_limit,
+                         .soft_nodes = config.soft_node_limit});
 
-    search.NewGame();
-    thread->NewGame();
+  // The game has ended
+  if (!best_move) {
+    return state.InCheck() ? state.turn == Color::kBlack : 0.5;
+  }
 
-    const auto [initial_score, _] = search.DataGenStart(
-        thread, search::TimeConfig{.depth = 10, .nodes = 1'000'000});
+  std::optional<double> wdl_outcome;
+  if (std::abs(score) >= kTBWinInMaxPlyScore) {
+    // Return the correct score depending on who is getting checkmated
+    wdl_outcome = score > 0;
+  } else {
+    const int scaled_win_threshold =
+        kWinThreshold -
+        800 * std::clamp<double>(state.half_moves, 0, 200) / 200;
+    if (score >= scaled_win_threshold) {
+      ++slot.win_plies, slot.loss_plies = slot.draw_plies = 0;
+    } else if (score <= -scaled_win_threshold) {
+      ++slot.loss_plies, slot.win_plies = slot.draw_plies = 0;
+    } else if (std::abs(score) <= kDrawThreshold) {
+      ++slot.draw_plies, slot.win_plies = slot.loss_plies = 0;
+    }
 
-    if (std::abs(initial_score) >= kInitialScoreThreshold) {
-      --i;
-      continue;
+    if (slot.win_plies >= kWinPliesThreshold) {
+      wdl_outcome = 1.0;
+    } else if (slot.loss_plies >= kWinPliesThreshold) {
+      wdl_outcome = 0.0;
+    } else if (slot.draw_plies >= kDrawPliesThreshold ||
+               state.half_moves >= 200) {
+      wdl_outcome = 0.5;
     }
+  }
 
-    U64 win_plies = 0, loss_plies = 0, draw_plies = 0;
+  board.MakeMove(best_move);
 
-    std::optional<double> wdl_outcome;
-    while (!stop) {
-      // Score returned as white-relative
-      const auto [score, best_move] = search.DataGenStart(thread, time_config);
+  // Check for draw here since search doesn't terminate with an adjudicated
+  // draw score at root
+  if (board.IsDraw(0)) {
+    return 0.5;
+  }
 
-      // The game has ended
-      if (!best_move) {
-        wdl_outcome = state.InCheck() ? state.turn == Color::kBlack : 0.5;
-        break;
-      } else {
-        if (std::abs(score) >= kTBWinInMaxPlyScore) {
-          // Return the correct score depending on who is getting checkmated
-          wdl_outcome = score > 0;
-        } else {
-          const int scaled_win_threshold =
-              kWinThreshold -
-              800 * std::clamp<double>(state.half_moves, 0, 200) / 200;
-          if (score >= scaled_win_threshold) {
-            ++win_plies, loss_plies = draw_plies = 0;
-          } else if (score <= -scaled_win_threshold) {
-            ++loss_plies, win_plies = draw_plies = 0;
-          } else if (std::abs(score) <= kDrawThreshold) {
-            ++draw_plies, win_plies = loss_plies = 0;
-          }
-
-          if (win_plies >= kWinPliesThreshold) {
-            wdl_outcome = 1.0;
-          } else if (loss_plies >= kWinPliesThreshold) {
-            wdl_outcome = 0.0;
-          } else if (draw_plies >= kDrawPliesThreshold ||
-                     state.half_moves >= 200) {
-            wdl_outcome = 0.5;
-          }
-        }
-      }
+  slot.formatter.PushMove(best_move, state.turn, score);
+  return wdl_outcome;
+}
+
+void FinishGame(const Config &config,
+                int thread_id,
+                GameSlot &slot,
+                double wdl_outcome,
+                GameWriter &writer) {
+  const U64 positions = slot.formatter.WriteOutcome(wdl_outcome);
+  const auto written =
+      positions_written.fetch_add(positions, std::memory_order_relaxed);
+  writer.Push(thread_id, {std::move(slot.game_stream).str(), positions});
+  slot.game_stream.str({});
+
+  const auto completed =
+      games_completed.fetch_add(1, std::memory_order_relaxed) + 1;
+
+  if (completed % std::clamp<U64>(config.num_games / 50, 1, 1000) == 0 ||
+      completed == 1) {
+    PrintProgress(config, completed, written);
+  }
+}
 
-      thread->board.MakeMove(best_move);
+void GameLoop(const Config &config,
+              int thread_id,
+              U64 seed,
+              GameWriter &writer) {
+  mt_generator.seed(seed);
 
-      // Check for draw here since search doesn't terminate with an adjudicated
-      // draw score at root
-      if (thread->board.IsDraw(0)) {
-        wdl_outcome = 0.5;
-        break;
-      }
+  std::vector<std::unique_ptr<GameSlot>> slots(config.games_in_flight);
+  for (auto &slot : slots) {
+    slot = std::make_unique<GameSlot>();
+  }
 
-      formatter.PushMove(best_move, state.turn, score);
+  // All games of the thread search with one transposition table
+  search::Search search(slots.front()->thread->board);
+  search.ResizeHash(16);
 
-      if (wdl_outcome) {
-        break;
-      }
+  // History carried over between games is also shared by the games in flight,
+  // apart from the quiet and capture tables
+  if (!config.clear_history && slots.size() > 1) {
+    const auto continuation_history =
+        std::make_shared<search::history::ContinuationHistory>();
+    const auto correction_history =
+        std::make_shared<search::history::CorrectionHistory>();
+    for (auto &slot : slots) {
+      slot->thread->history.SetSharedTables(continuation_history,
+                                            correction_history);
     }
+  }
 
-    if (wdl_outcome) {
-      const auto written = positions_written.fetch_add(
-          formatter.WriteOutcome(*wdl_outcome), std::memory_order_relaxed);
-      const auto completed =
-          games_completed.fetch_add(1, std::memory_order_relaxed) + 1;
+  for (auto &slot : slots) {
+    slot->active = StartGame(config, search, *slot);
+  }
 
-      if (completed % std::min<U64>(config.num_games / 50, 1000ULL) == 0 ||
-          completed == 1) {
-        PrintProgress(config, completed, written);
+  // Every round plays one move in each game in flight, replacing the games
+  // that end with new ones until there are none left to claim
+  bool any_active = true;
+  while (!stop && any_active) {
+    any_active = false;
+    for (auto &slot : slots) {
+      if (stop || !slot->active) continue;
+
+      if (const auto wdl_outcome = PlayMove(config, search, *slot)) {
+        FinishGame(config, thread_id, *slot, *wdl_outcome, writer);
+        slot->active = StartGame(config, search, *slot);
       }
+
+      any_active |= slot->active;
     }
   }
 
@@ -282,60 +388,276 @@ void GameLoop(const Config &config,
                 positions_written.load(std::memory_order_relaxed));
 }
 
+// How often the output is synced to disk and the checkpoint updated
+constexpr std::chrono::seconds kCheckpointInterval(60);
+
 void signal_handler([[maybe_unused]] int signum) {
   stop = true;
 }
 
-void Generate(Config config) {
+// Makes the data written to the file so far survive a crash of the machine
+void SyncFile(const std::string &path) {
+#if defined(__unix__)
+  // Syncing any descriptor of the file flushes the data of all of them
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd != -1) {
+    fsync(fd);
+    close(fd);
+  }
+#endif
+}
+
+std::string CheckpointPath(const std::string &path) {
+  return path + ".checkpoint";
+}
+
+// Records how far the output file got once its data is on disk. The sidecar
+// is replaced through a rename, so it's never seen half written
+void WriteCheckpoint(const std::string &path,
+                     const WriterTotals &totals,
+                     const std::vector<U64> &seeds) {
+  SyncFile(path);
+
+  const auto checkpoint_path = CheckpointPath(path);
+  const auto temp_path = checkpoint_path + ".tmp";
+  {
+    std::ofstream checkpoint(temp_path, std::ios::trunc);
+    checkpoint << fmt::format("games {}\npositions {}\nbytes {}\n",
+                              totals.games,
+                              totals.positions,
+                              totals.bytes);
+    for (std::size_t i = 0; i < seeds.size(); i++) {
+      checkpoint << fmt::format("seed {} {}\n", i, seeds[i]);
+    }
+    if (!checkpoint) return;
+  }
+
+  SyncFile(temp_path);
+  std::error_code error;
+  std::filesystem::rename(temp_path, checkpoint_path, error);
+}
+
+// What a checkpoint recorded about the run it belongs to
+struct Checkpoint {
+  WriterTotals totals;
+  // The seeds each thread started the run with
+  std::vector<U64> seeds;
+};
+
+Checkpoint ReadCheckpoint(const std::string &path) {
+  Checkpoint result;
+
+  std::ifstream checkpoint(CheckpointPath(path));
+  std::string key;
+  U64 value;
+  while (checkpoint >> key) {
+    if (key == "seed") {
+      U64 index;
+      // The seeds are written in thread order
+      if (!(checkpoint >> index >> value) || index != result.seeds.size()) {
+        break;
+      }
+      result.seeds.push_back(value);
+    } else if (checkpoint >> value) {
+      if (key == "games") result.totals.games = value;
+      if (key == "positions") result.totals.positions = value;
+      if (key == "bytes") result.totals.bytes = value;
+    }
+  }
+
+  return result;
+}
+
+// Derives the seed a thread continues a resumed run with from the seed it
+// started the run with and the number of games already written. Resuming the
+// same file then always continues the same way, without replaying the
+// openings the run started with
+U64 ResumeSeed(U64 seed, U64 games) {
+  std::seed_seq sequence{static_cast<U32>(seed),
+                         static_cast<U32>(seed >> 32),
+                         static_cast<U32>(games),
+                         static_cast<U32>(games >> 32)};
+  std::array<U32, 2> mixed;
+  sequence.generate(mixed.begin(), mixed.end());
+  return static_cast<U64>(mixed[0]) << 32 | mixed[1];
+}
+
+// Walks the games, or the compressed blocks of games, written after the last
+// checkpoint, which the writer may have flushed before the run died, and
+// truncates the file after the last one that was written whole
+std::optional<Checkpoint> RecoverOutput(const std::string &path,
+                                        bool compressed) {
+  std::error_code error;
+  const U64 file_size = std::filesystem::file_size(path, error);
+  if (error) {
+    fmt::println("Error: Failed to read output file {} to resume", path);
+    return std::nullopt;
+  }
+
+  auto checkpoint = ReadCheckpoint(path);
+  auto &totals = checkpoint.totals;
+  if (totals.bytes > file_size) {
+    fmt::println("Error: Checkpoint of {} is past the end of the file", path);
+    return std::nullopt;
+  }
+
+  {
+    const format::BinPackFile file(path);
+    if (!file.IsOpen()) {
+      fmt::println("Error: Failed to read output file {} to resume", path);
+      return std::nullopt;
+    }
+
+    if (compressed && file.Size() < format::kFileHeaderSize) {
+      // The run died before its header was written whole, which the writer
+      // writes again once the file is emptied
+      totals = {};
+    } else if (file.Size() > 0 &&
+               format::IsCompressedBinPack(file.Data(), file.Size()) !=
+                   compressed) {
+      fmt::println("Error: {} was written {} compression",
+                   path,
+                   compressed ? "without" : "with");
+      return std::nullopt;
+    }
+
+    const char *begin = file.Data() + totals.bytes;
+    const char *end = file.Data() + file.Size();
+    format::BinPackGame game;
+
+    if (compressed) {
+      // Blocks only start after the file header
+      if (file.Size() >= format::kFileHeaderSize &&
+          totals.bytes < format::kFileHeaderSize) {
+        totals.bytes = format::kFileHeaderSize;
+        begin = file.Data() + totals.bytes;
+      }
+
+      format::BlockReader blocks(begin, end);
+      format::CompressedBlock block;
+      format::BlockDecompressor decompressor;
+      while (blocks.Next(block) && decompressor.Decompress(block)) {
+        format::BinPackReader reader(
+            decompressor.Data(), decompressor.Data() + decompressor.Size());
+        WriterTotals block_totals;
+        while (reader.Next(game)) {
+          ++block_totals.games;
+          block_totals.positions += game.num_moves;
+        }
+        if (reader.Remaining() > 0) break;
+
+        totals.games += block_totals.games;
+        totals.positions += block_totals.positions;
+        totals.bytes += block.StoredSize();
+      }
+    } else {
+      format::BinPackReader reader(begin, end);
+      while (reader.Next(game)) {
+        ++totals.games;
+        totals.positions += game.num_moves;
+      }
+      totals.bytes += reader.Offset();
+    }
+  }
+
+  if (totals.bytes < file_size) {
+    fmt::println("Truncating {} bytes of a partially written {}",
+                 file_size - totals.bytes,
+                 compressed ? "block" : "game");
+    std::filesystem::resize_file(path, totals.bytes, error);
+    if (error) {
+      fmt::println("Error: Failed to truncate output file {}", path);
+      return std::nullopt;
+    }
+  }
+
+  return checkpoint;
+}
+
+std::string Generate(Config config) {
   fmt::println("Starting data generation process...\n");
 
-  games_completed = positions_written = 0;
+  games_completed = positions_written = games_claimed = 0;
+  games_resumed = positions_resumed = 0;
 
   // Handle Ctrl + C
   std::signal(SIGINT, signal_handler);
 
-  // Change the number of games to fit evenly within the number of threads
-  config.num_games -= config.num_games % config.num_threads;
+  std::string path = config.output_file;
+  WriterTotals initial_totals;
+  std::vector<U64> run_seeds;
+
+  if (config.resume) {
+    const auto recovered = RecoverOutput(path, config.compress);
+    if (!recovered) return {};
+
+    initial_totals = recovered->totals;
+    run_seeds = recovered->seeds;
+    games_completed = games_claimed = games_resumed = initial_totals.games;
+    positions_written = positions_resumed = initial_totals.positions;
+    if (initial_totals.games >= config.num_games) {
+      fmt::println("{} already holds {} games", path, initial_totals.games);
+      return path;
+    }
+
+    fmt::println("Resuming {} from {} games and {} positions\n",
+                 path,
+                 initial_totals.games,
+                 initial_totals.positions);
+  } else {
+    const auto time = std::time(nullptr);
+    const auto tm = *std::localtime(&time);
+
+    std::stringstream buffer;
+    buffer << std::put_time(&tm, "%d-%m-%Y");
+    path += "-" + buffer.str();
+  }
 
-  const auto time = std::time(nullptr);
-  const auto tm = *std::localtime(&time);
+  const auto open_mode = config.resume ? std::ios::app : std::ios::trunc;
+  std::ofstream output_stream(path, std::ios::binary | open_mode);
+  if (!output_stream) {
+    fmt::println(
+        "Error: Failed to open output file {} '{}'", path, strerror(errno));
+    return {};
+  }
 
-  std::stringstream buffer;
-  buffer << std::put_time(&tm, "%d-%m-%Y");
+  // A new run picks fresh seeds, which are recorded alongside the checkpoint.
+  // A resumed run keeps the seeds of the run it continues, only picking ones
+  // for threads that run didn't have
+  std::random_device random_device;
+  const std::size_t recorded_seeds = run_seeds.size();
+  run_seeds.resize(std::max<std::size_t>(recorded_seeds, config.num_threads));
+  for (std::size_t i = recorded_seeds; i < run_seeds.size(); i++) {
+    run_seeds[i] = (static_cast<U64>(random_device()) << 32) ^
+                   random_device() ^ search::GetCurrentTime();
+  }
+
+  std::vector<U64> seeds(run_seeds.begin(),
+                         run_seeds.begin() + config.num_threads);
+  if (config.resume) {
+    for (auto &seed : seeds) {
+      seed = ResumeSeed(seed, initial_totals.games);
+    }
+  }
 
-  const auto path = config.output_file + "-" + buffer.str();
   start_time = search::GetCurrentTime();
 
+  GameWriter writer(output_stream,
+                    config.num_threads,
+                    initial_totals,
+                    config.compress ? format::kDefaultBlockSize : 0);
+  writer.SetCheckpoint(kCheckpointInterval,
+                       [&path, &run_seeds](const WriterTotals &totals) {
+                         WriteCheckpoint(path, totals, run_seeds);
+                       });
+  std::thread writer_thread([&writer]() { writer.Run(); });
+
   std::vector<std::thread> threads;
   threads.reserve(config.num_threads);
 
-  std::vector<std::string> temp_files;
-
   for (int i = 0; i < config.num_threads; i++) {
-    auto thread_path = path + fmt::format("_temp{}", i);
-    temp_files.push_back(thread_path);
-
-    threads.emplace_back([&config, thread_path = std::move(thread_path), i]() {
-      std::ofstream output_stream(thread_path,
-                                  std::ios::binary | std::ios::app);
-      if (!output_stream) {
-        fmt::println("Error: Failed to open output file {} for thread {} '{}'",
-                     thread_path,
-                     i,
-                     strerror(errno));
-        return;
-      }
-
-      GameLoop(config, i, output_stream);
-
-      output_stream.close();
-      if (output_stream.good()) {
-        // Explicitly flush to ensure all data is written
-        output_stream.flush();
-      } else {
-        fmt::println(
-            "Error: Thread {} encountered an issue while closing the file", i);
-      }
+    threads.emplace_back([&config, &writer, seed = seeds[i], i]() {
+      GameLoop(config, i, seed, writer);
     });
   }
 
@@ -343,49 +665,18 @@ void Generate(Config config) {
     thread.join();
   }
 
-  // Add a small delay to ensure file system sync
-  std::this_thread::sleep_for(std::chrono::seconds(1));
+  writer.Finish();
+  writer_thread.join();
 
+  output_stream.close();
   fmt::println("");
 
-  // Concatenate all temp files into one big file
-  std::ofstream final_output(path, std::ios::binary);
-  if (!final_output) {
-    fmt::println("Error: Failed to open final output file {}", path);
-    return;
+  if (!output_stream) {
+    fmt::println("Error: Failed to write output file {}", path);
+    return {};
   }
 
-  int concatenated_files = 0;
-  for (const auto &temp_file : temp_files) {
-    std::ifstream input(temp_file, std::ios::binary);
-    if (input) {
-      final_output << input.rdbuf();
-      input.close();
-      // Delete the temp file
-      if (std::remove(temp_file.c_str()) == 0) {
-        concatenated_files++;
-        fmt::println("Successfully concatenated and removed temp file {}",
-                     temp_file);
-      } else {
-        fmt::println(
-            "Error: Failed to remove temp file {} after concatenation. Error: "
-            "{}",
-            temp_file,
-            strerror(errno));
-      }
-    } else {
-      fmt::println(
-          "Error: Failed to open temp file {} for concatenation. Error: {}",
-          temp_file,
-          strerror(errno));
-    }
-  }
-
-  final_output.close();
-
-  fmt::println("Concatenated {} out of {} expected temp files",
-               concatenated_files,
-               config.num_threads);
+  return path;
 }
 
 }  // namespace data_gen
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define INTEGRAL_DATAGEN_H
 
 #include <atomic>
+#include <string>
 
 #include "../utils/types.h"
 
@@ -20,9 +21,30 @@ struct Config {
   I32 num_threads = 0;
   I32 min_move_plies = 8, max_move_plies = 9;
   std::string output_file;
+  // Whether the history tables are cleared between games, or carried over
+  // from the previous game played by the same thread
+  bool clear_history = true;
+  // Whether the transposition table is cleared between games, or only aged so
+  // that entries from earlier games are replaced first. Threads playing
+  // several games in flight always only age it
+  bool clear_tt = true;
+  // Node limit of the search that filters out lopsided starting positions
+  U64 verification_nodes = 1'000'000;
+  // Starting positions that search scores at least this far from even are
+  // rejected and replaced with another
+  I32 max_opening_score = 1000;
+  // Games each thread plays in lockstep, one move of each game at a time
+  I32 games_in_flight = 1;
+  // Whether output_file names the file of an interrupted run, which is then
+  // appended to until it holds num_games games
+  bool resume = false;
+  // Whether the games are written in independently compressed blocks
+  bool compress = false;
 };
 
-void Generate(Config config);
+// Returns the path of the file the games were written to, or nothing when the
+// run failed
+std::string Generate(Config config);
 
 }  // namespace data_gen
 
@@ -0,0 +1,1064 @@
+#include "data_tool.h"
+
+#include <fmt/format.h>
+
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <span>
+#include <thread>
+
+#include "../chess/board.h"
+#include "../chess/fen.h"
+#include "../chess/move_gen.h"
+#include "../engine/evaluation/evaluation.h"
+#include "../engine/search/search.h"
+#include "../utils/bloom_filter.h"
+#include "format/binpack_reader.h"
+#include "format/compressed_binpack.h"
+
+namespace data_gen {
+
+// Games are processed in chunks of about this many bytes, which are handed out
+// to the threads one at a time. Searching every position takes so much longer
+// that it uses smaller chunks to keep the threads busy until the end
+constexpr U64 kChunkSize = 4ULL << 20;
+constexpr U64 kSearchChunkSize = 16ULL << 10;
+
+// Chunks that can be processed ahead of the one being written, per thread
+constexpr std::size_t kChunksAheadPerThread = 4;
+
+// Only the first few problems are printed, the rest are just counted
+constexpr U64 kMaxReportedErrors = 20;
+
+// A decided game whose final score points this far the other way is counted,
+// but isn't an error since games can be adjudicated or blundered late
+constexpr int kDisagreementThreshold = 1000;
+
+constexpr int kMaxPhase = 24;
+constexpr int kEvalBucketWidth = 200, kNumEvalBuckets = 21;
+constexpr int kLengthBucketWidth = 25, kNumLengthBuckets = 17;
+
+struct Chunk {
+  U64 begin, end;
+  // Where the chunk's games start once decompressed, which is begin unless
+  // the file is compressed
+  U64 raw_begin;
+};
+
+struct DatasetStats {
+  U64 games = 0, positions = 0;
+  // Indexed by the stored outcome: white loss, draw and white win
+  std::array<U64, 3> outcomes{};
+  std::array<U64, kNumEvalBuckets> evals{};
+  std::array<U64, kMaxPhase + 1> phases{};
+  std::array<U64, kNumLengthBuckets> lengths{};
+
+  U64 invalid_headers = 0, illegal_moves = 0, invalid_outcomes = 0;
+  U64 mate_mismatches = 0, eval_disagreements = 0, corrupt_blocks = 0;
+
+  [[nodiscard]] U64 Errors() const {
+    return invalid_headers + illegal_moves + invalid_outcomes +
+           mate_mismatches + corrupt_blocks;
+  }
+
+  void Merge(const DatasetStats &other) {
+    games += other.games, positions += other.positions;
+    for (std::size_t i = 0; i < outcomes.size(); i++) {
+      outcomes[i] += other.outcomes[i];
+    }
+    for (std::size_t i = 0; i < evals.size(); i++) evals[i] += other.evals[i];
+    for (std::size_t i = 0; i < phases.size(); i++) {
+      phases[i] += other.phases[i];
+    }
+    for (std::size_t i = 0; i < lengths.size(); i++) {
+      lengths[i] += other.lengths[i];
+    }
+    invalid_headers += other.invalid_headers;
+    illegal_moves += other.illegal_moves;
+    invalid_outcomes += other.invalid_outcomes;
+    mate_mismatches += other.mate_mismatches;
+    eval_disagreements += other.eval_disagreements;
+    corrupt_blocks += other.corrupt_blocks;
+  }
+};
+
+std::atomic<U64> errors_reported = 0;
+std::mutex report_mutex;
+
+template <typename... Args>
+void ReportError(U64 offset,
+                 fmt::format_string<Args...> format,
+                 Args &&...args) {
+  if (errors_reported.fetch_add(1, std::memory_order_relaxed) >=
+      kMaxReportedErrors) {
+    return;
+  }
+
+  std::lock_guard lock(report_mutex);
+  fmt::println("Error: game at byte {}: {}",
+               offset,
+               fmt::format(format, std::forward<Args>(args)...));
+}
+
+void ReportCorruptBlock(U64 offset) {
+  if (errors_reported.fetch_add(1, std::memory_order_relaxed) >=
+      kMaxReportedErrors) {
+    return;
+  }
+
+  std::lock_guard lock(report_mutex);
+  fmt::println("Error: block at byte {} is corrupt", offset);
+}
+
+int GamePhase(const BoardState &state) {
+  return std::min(kMaxPhase,
+                  (state.Knights() | state.Bishops()).PopCount() +
+                      2 * state.Rooks().PopCount() +
+                      4 * state.Queens().PopCount());
+}
+
+// Splits the file at game boundaries into chunks that can be replayed
+// independently. Finding a boundary needs every game before it to be walked,
+// so this pass only looks for terminators and runs at memory speed
+std::vector<Chunk> SplitIntoChunks(const format::BinPackFile &file,
+                                   U64 chunk_size,
+                                   U64 &trailing_bytes) {
+  std::vector<Chunk> chunks;
+
+  format::BinPackReader reader(file.Data(), file.Data() + file.Size());
+  format::BinPackGame game;
+
+  U64 chunk_begin = 0;
+  while (reader.Next(game)) {
+    if (reader.Offset() - chunk_begin >= chunk_size) {
+      chunks.push_back({chunk_begin, reader.Offset(), chunk_begin});
+      chunk_begin = reader.Offset();
+    }
+  }
+  if (reader.Offset() > chunk_begin) {
+    chunks.push_back({chunk_begin, reader.Offset(), chunk_begin});
+  }
+
+  trailing_bytes = reader.Remaining();
+  return chunks;
+}
+
+// Every block of a compressed file is a chunk of its own, which is found from
+// the block headers alone
+std::vector<Chunk> SplitIntoBlocks(const format::BinPackFile &file,
+                                   U64 &trailing_bytes) {
+  std::vector<Chunk> chunks;
+
+  format::BlockReader reader(file.Data() + format::kFileHeaderSize,
+                             file.Data() + file.Size());
+  format::CompressedBlock block;
+
+  U64 raw_offset = 0;
+  while (reader.Next(block)) {
+    const U64 offset = format::kFileHeaderSize + block.offset;
+    chunks.push_back({offset, offset + block.StoredSize(), raw_offset});
+    raw_offset += block.header.raw_size;
+  }
+
+  trailing_bytes = reader.Remaining();
+  return chunks;
+}
+
+// Calls visit() with every game of a plain or compressed file in file order,
+// with the game's offset into the decompressed games. Corrupt blocks are
+// reported and skipped, and the bytes past the last whole game or block are
+// returned
+template <typename Visit>
+U64 ForEachGame(const format::BinPackFile &file, Visit visit) {
+  format::BinPackGame game;
+
+  if (!format::IsCompressedBinPack(file.Data(), file.Size())) {
+    format::BinPackReader reader(file.Data(), file.Data() + file.Size());
+    while (reader.Next(game)) visit(game, game.offset);
+    return reader.Remaining();
+  }
+
+  U64 trailing_bytes = 0;
+  format::BlockDecompressor decompressor;
+  for (const auto &chunk : SplitIntoBlocks(file, trailing_bytes)) {
+    format::BlockReader blocks(file.Data() + chunk.begin,
+                               file.Data() + chunk.end);
+    format::CompressedBlock block;
+    if (!blocks.Next(block) || !decompressor.Decompress(block)) {
+      ReportCorruptBlock(chunk.begin);
+      continue;
+    }
+
+    format::BinPackReader reader(decompressor.Data(),
+                                 decompressor.Data() + decompressor.Size());
+    while (reader.Next(game)) visit(game, chunk.raw_begin + game.offset);
+  }
+
+  return trailing_bytes;
+}
+
+// A chunk's output, waiting to be written in order
+struct ProcessedChunk {
+  std::string output;
+  std::atomic_bool done = false;
+};
+
+// Runs a worker over every chunk on the given number of threads, and hands
+// their outputs to write() in chunk order as soon as they are done. Each
+// thread makes its own worker, which is called with a chunk's index and the
+// string to append its output to
+template <typename MakeWorker, typename Write>
+void ProcessChunksInOrder(std::size_t num_chunks,
+                          int num_threads,
+                          MakeWorker make_worker,
+                          Write write) {
+  // Threads never get more than a window of chunks ahead of the one being
+  // written, which bounds the memory taken by their outputs
+  const std::size_t window = kChunksAheadPerThread * num_threads;
+  std::vector<ProcessedChunk> processed(window);
+
+  std::atomic<std::size_t> next_chunk = 0, chunks_written = 0;
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back([&]() {
+      auto worker = make_worker();
+
+      std::size_t chunk_index;
+      while ((chunk_index = next_chunk.fetch_add(
+                  1, std::memory_order_relaxed)) < num_chunks) {
+        std::size_t written;
+        while (chunk_index >=
+               (written = chunks_written.load(std::memory_order_acquire)) +
+                   window) {
+          chunks_written.wait(written, std::memory_order_acquire);
+        }
+
+        auto &slot = processed[chunk_index % window];
+        worker(chunk_index, slot.output);
+
+        slot.done.store(true, std::memory_order_release);
+        slot.done.notify_one();
+      }
+    });
+  }
+
+  for (std::size_t i = 0; i < num_chunks; i++) {
+    auto &slot = processed[i % window];
+    slot.done.wait(false, std::memory_order_acquire);
+
+    write(i, slot.output);
+    slot.output.clear();
+    slot.done.store(false, std::memory_order_relaxed);
+
+    chunks_written.store(i + 1, std::memory_order_release);
+    chunks_written.notify_all();
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+void ValidateGame(const format::BinPackGame &game,
+                  U64 offset,
+                  Board &board,
+                  DatasetStats &stats) {
+  ++stats.games;
+  stats.lengths[std::min<U64>(game.num_moves / kLengthBucketWidth,
+                              kNumLengthBuckets - 1)]++;
+
+  const U8 outcome = game.board.wdl_outcome;
+  if (outcome > 2) {
+    ++stats.invalid_outcomes;
+    ReportError(offset, "outcome {} isn't a loss, draw or win", outcome);
+  } else {
+    ++stats.outcomes[outcome];
+  }
+
+  BoardState state;
+  if (!format::DecodeBoardState(game.board, state) ||
+      move_gen::IsSquareAttacked(state.King(FlipColor(state.turn)).GetLsb(),
+                                 state.turn,
+                                 state)) {
+    ++stats.invalid_headers;
+    ReportError(offset, "header doesn't describe a legal position");
+    return;
+  }
+  board.SetFromState(state);
+
+  Score last_score = 0;
+  for (U64 i = 0; i < game.num_moves; i++) {
+    const auto [move_data, score] = game.GetMove(i);
+    const auto &current = board.GetState();
+
+    ++stats.positions;
+    stats.phases[GamePhase(current)]++;
+    stats.evals[std::clamp((score + kEvalBucketWidth * (kNumEvalBuckets / 2)) /
+                               kEvalBucketWidth,
+                           0,
+                           kNumEvalBuckets - 1)]++;
+    last_score = score;
+
+    const Move move = format::DecodeMove(move_data);
+    if (!board.IsMovePseudoLegal(move) || !board.IsMoveLegal(move)) {
+      ++stats.illegal_moves;
+      ReportError(offset,
+                  "move {} ({}) is illegal in {}",
+                  i + 1,
+                  move.ToString(),
+                  fen::BoardToString(current));
+      return;
+    }
+    board.MakeMove(move);
+  }
+
+  if (outcome > 2) return;
+
+  // Games that end on the board must be scored by how they ended
+  const auto &final_state = board.GetState();
+  if (move_gen::GenerateLegalMoves(MoveGenType::kAll, board).Empty()) {
+    const U8 expected =
+        !final_state.InCheck() ? 1 : final_state.turn == Color::kWhite ? 0 : 2;
+    if (outcome != expected) {
+      ++stats.mate_mismatches;
+      ReportError(offset,
+                  "game ends in {} but is scored {}",
+                  final_state.InCheck() ? "checkmate" : "stalemate",
+                  outcome);
+    }
+  } else if ((outcome == 2 && last_score <= -kDisagreementThreshold) ||
+             (outcome == 0 && last_score >= kDisagreementThreshold)) {
+    ++stats.eval_disagreements;
+  }
+}
+
+void PrintHistogram(std::string_view title,
+                    std::span<const U64> counts,
+                    const std::function<std::string(std::size_t)> &label) {
+  constexpr int kBarWidth = 40;
+
+  const U64 total = std::max<U64>(std::accumulate(counts.begin(),
+                                                  counts.end(),
+                                                  0ULL),
+                                  1);
+  const U64 largest = std::max<U64>(std::ranges::max(counts), 1);
+
+  fmt::println("\n{}", title);
+  for (std::size_t i = 0; i < counts.size(); i++) {
+    std::string bar;
+    for (U64 j = 0; j < counts[i] * kBarWidth / largest; j++) {
+      bar += "█";  // Full block
+    }
+    fmt::println("{:>12} {:>12} {:>6.2f}% {}",
+                 label(i),
+                 counts[i],
+                 100.0 * counts[i] / total,
+                 bar);
+  }
+}
+
+void PrintStats(const DatasetStats &stats) {
+  fmt::println("\nwhite wins: {}  draws: {}  black wins: {}",
+               stats.outcomes[2],
+               stats.outcomes[1],
+               stats.outcomes[0]);
+  fmt::println("plies per game: {:.1f}",
+               static_cast<double>(stats.positions) /
+                   std::max<U64>(stats.games, 1));
+
+  PrintHistogram("eval (white relative)", stats.evals, [](std::size_t i) {
+    const int lower = static_cast<int>(i) * kEvalBucketWidth -
+                      kEvalBucketWidth * (kNumEvalBuckets / 2);
+    if (i == 0) return fmt::format("< {}", lower + kEvalBucketWidth);
+    if (i == kNumEvalBuckets - 1) return fmt::format(">= {}", lower);
+    return fmt::format("{}", lower);
+  });
+
+  PrintHistogram("phase (24 = all pieces)", stats.phases, [](std::size_t i) {
+    return fmt::format("{}", i);
+  });
+
+  PrintHistogram("plies per game", stats.lengths, [](std::size_t i) {
+    const auto lower = i * kLengthBucketWidth;
+    if (i == kNumLengthBuckets - 1) return fmt::format(">= {}", lower);
+    return fmt::format("{}-{}", lower, lower + kLengthBucketWidth - 1);
+  });
+}
+
+void ValidateBinPack(const std::string &path, int num_threads) {
+  const format::BinPackFile file(path);
+  if (!file.IsOpen()) {
+    fmt::println("Error: Failed to open binpack file {}", path);
+    return;
+  }
+
+  const bool compressed =
+      format::IsCompressedBinPack(file.Data(), file.Size());
+  const double megabytes = file.Size() / (1024.0 * 1024.0);
+  fmt::println("validating {}{} ({:.1f} MB) on {} threads",
+               compressed ? "compressed " : "",
+               path,
+               megabytes,
+               num_threads);
+
+  errors_reported = 0;
+
+  auto start_time = search::GetCurrentTime();
+  U64 trailing_bytes = 0;
+  const auto chunks = compressed
+                        ? SplitIntoBlocks(file, trailing_bytes)
+                        : SplitIntoChunks(file, kChunkSize, trailing_bytes);
+  const auto scan_time =
+      std::max<U64>(search::GetCurrentTime() - start_time, 1);
+  fmt::println("scanned {} {} in {} ms ({:.0f} MB/s)",
+               chunks.size(),
+               compressed ? "blocks" : "chunks",
+               scan_time,
+               megabytes / (scan_time / 1000.0));
+  if (compressed) {
+    fmt::println("game offsets are into the decompressed games");
+  }
+
+  start_time = search::GetCurrentTime();
+
+  std::atomic<std::size_t> next_chunk = 0;
+  std::vector<DatasetStats> thread_stats(num_threads);
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back([&, i]() {
+      Board board(BoardMode::kMovesOnly);
+      format::BinPackGame game;
+      format::BlockDecompressor decompressor;
+      auto &stats = thread_stats[i];
+
+      std::size_t chunk_index;
+      while ((chunk_index = next_chunk.fetch_add(
+                  1, std::memory_order_relaxed)) < chunks.size()) {
+        const auto &chunk = chunks[chunk_index];
+        const char *begin = file.Data() + chunk.begin;
+        const char *end = file.Data() + chunk.end;
+
+        if (compressed) {
+          format::BlockReader blocks(begin, end);
+          format::CompressedBlock block;
+          if (!blocks.Next(block) || !decompressor.Decompress(block)) {
+            ++stats.corrupt_blocks;
+            ReportCorruptBlock(chunk.begin);
+            continue;
+          }
+          begin = decompressor.Data();
+          end = begin + decompressor.Size();
+        }
+
+        format::BinPackReader reader(begin, end);
+        while (reader.Next(game)) {
+          ValidateGame(game, chunk.raw_begin + game.offset, board, stats);
+        }
+
+        // Blocks are only ever written with whole games
+        if (compressed && reader.Remaining() > 0) {
+          ++stats.corrupt_blocks;
+          ReportCorruptBlock(chunk.begin);
+        }
+      }
+    });
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  DatasetStats stats;
+  for (const auto &thread_stat : thread_stats) {
+    stats.Merge(thread_stat);
+  }
+
+  const auto replay_time =
+      std::max<U64>(search::GetCurrentTime() - start_time, 1);
+  fmt::println("replayed {} games and {} positions in {} ms ({:.0f} MB/s)",
+               stats.games,
+               stats.positions,
+               replay_time,
+               megabytes / (replay_time / 1000.0));
+
+  PrintStats(stats);
+
+  fmt::println("");
+  if (trailing_bytes > 0) {
+    fmt::println("Error: last {} bytes are a {}",
+                 trailing_bytes,
+                 compressed ? "cut off or corrupt block"
+                            : "game without its terminator");
+  }
+  if (compressed) {
+    fmt::println("corrupt blocks: {}", stats.corrupt_blocks);
+  }
+  fmt::println("invalid headers: {}  illegal moves: {}  invalid outcomes: {}",
+               stats.invalid_headers,
+               stats.illegal_moves,
+               stats.invalid_outcomes);
+  fmt::println("mate/stalemate outcome mismatches: {}", stats.mate_mismatches);
+  fmt::println("decided games with a final eval of {}+ the other way: {}",
+               kDisagreementThreshold,
+               stats.eval_disagreements);
+  fmt::println("{}",
+               stats.Errors() == 0 && trailing_bytes == 0 ? "file is valid"
+                                                           : "file is invalid");
+}
+
+// Per-thread state for rescoring, which only searches when given a node limit
+class Rescorer {
+ public:
+  explicit Rescorer(U64 nodes)
+      : thread_(std::make_unique<search::Thread>(0)),
+        search_(thread_->board),
+        nodes_(nodes) {
+    if (nodes_ > 0) search_.ResizeHash(16);
+  }
+
+  // Appends the game with every position scored again, or nothing when the
+  // game can't be replayed
+  bool Rescore(const format::BinPackGame &game, std::string &output) {
+    BoardState state;
+    if (!format::DecodeBoardState(game.board, state)) return false;
+
+    auto &board = thread_->board;
+    board.SetFromState(state);
+
+    // Every game starts from a clean table and history, so its scores don't
+    // depend on which thread rescored the games before it. The pawn cache is
+    // shared with the other rescoring threads, so it's left alone
+    if (nodes_ > 0) {
+      search_.NewGame(false);
+      search_.ClearHash();
+      thread_->NewGame();
+    }
+
+    const auto game_start = output.size();
+    output.append(reinterpret_cast<const char *>(&game.board),
+                  sizeof(game.board));
+
+    for (U64 i = 0; i < game.num_moves; i++) {
+      const Move move = format::DecodeMove(game.GetMove(i).first);
+      if (!board.IsMovePseudoLegal(move) || !board.IsMoveLegal(move)) {
+        output.resize(game_start);
+        return false;
+      }
+
+      const format::BinPackMove rescored = {game.GetMove(i).first,
+                                            static_cast<I16>(ScorePosition())};
+      output.append(reinterpret_cast<const char *>(&rescored),
+                    sizeof(rescored));
+
+      board.MakeMove(move);
+    }
+
+    output.append(reinterpret_cast<const char *>(&format::kNullBinPackMove),
+                  sizeof(format::kNullBinPackMove));
+    return true;
+  }
+
+ private:
+  // White relative, like the scores written during data generation
+  Score ScorePosition() {
+    if (nodes_ > 0) {
+      return search_.DataGenStart(thread_, search::TimeConfig{.nodes = nodes_})
+          .first;
+    }
+
+    const Score score = eval::Evaluate(thread_->board);
+    return thread_->board.GetState().turn == Color::kBlack ? -score : score;
+  }
+
+ private:
+  std::unique_ptr<search::Thread> thread_;
+  search::Search search_;
+  U64 nodes_;
+};
+
+void RescoreBinPack(const std::string &input_path,
+                    const std::string &output_path,
+                    int num_threads,
+                    U64 nodes) {
+  const format::BinPackFile file(input_path);
+  if (!file.IsOpen()) {
+    fmt::println("Error: Failed to open binpack file {}", input_path);
+    return;
+  }
+
+  std::ofstream output_stream(output_path, std::ios::binary | std::ios::trunc);
+  if (!output_stream) {
+    fmt::println("Error: Failed to open output file {}", output_path);
+    return;
+  }
+
+  if (nodes > 0) {
+    fmt::println("rescoring {} with {} node searches on {} threads",
+                 input_path,
+                 nodes,
+                 num_threads);
+  } else {
+    fmt::println("rescoring {} with the static evaluation on {} threads",
+                 input_path,
+                 num_threads);
+  }
+
+  errors_reported = 0;
+
+  // Compressed files are rescored a block at a time, and written out plain
+  const bool compressed =
+      format::IsCompressedBinPack(file.Data(), file.Size());
+  U64 trailing_bytes = 0;
+  const auto chunks =
+      compressed ? SplitIntoBlocks(file, trailing_bytes)
+                 : SplitIntoChunks(file,
+                                   nodes > 0 ? kSearchChunkSize : kChunkSize,
+                                   trailing_bytes);
+  if (trailing_bytes > 0) {
+    fmt::println("Error: last {} bytes are a {}, which is left out",
+                 trailing_bytes,
+                 compressed ? "cut off or corrupt block"
+                            : "game without its terminator");
+  }
+
+  std::atomic<U64> games = 0, positions = 0, skipped = 0;
+
+  const auto start_time = search::GetCurrentTime();
+  auto last_report = start_time;
+
+  const auto make_rescorer = [&]() {
+    return [&,
+            rescorer = std::make_unique<Rescorer>(nodes),
+            decompressor = format::BlockDecompressor()](
+               std::size_t chunk_index, std::string &output) mutable {
+      const auto &chunk = chunks[chunk_index];
+      const char *begin = file.Data() + chunk.begin;
+      const char *end = file.Data() + chunk.end;
+
+      if (compressed) {
+        format::BlockReader blocks(begin, end);
+        format::CompressedBlock block;
+        if (!blocks.Next(block) || !decompressor.Decompress(block)) {
+          ReportCorruptBlock(chunk.begin);
+          return;
+        }
+        begin = decompressor.Data();
+        end = begin + decompressor.Size();
+      }
+
+      format::BinPackReader reader(begin, end);
+      format::BinPackGame game;
+      while (reader.Next(game)) {
+        if (rescorer->Rescore(game, output)) {
+          games.fetch_add(1, std::memory_order_relaxed);
+          positions.fetch_add(game.num_moves, std::memory_order_relaxed);
+        } else {
+          skipped.fetch_add(1, std::memory_order_relaxed);
+          ReportError(chunk.raw_begin + game.offset,
+                      "game can't be replayed and is left out");
+        }
+      }
+    };
+  };
+
+  // The chunks are written here in file order as soon as they are done
+  ProcessChunksInOrder(
+      chunks.size(),
+      num_threads,
+      make_rescorer,
+      [&](std::size_t chunk_index, const std::string &output) {
+        output_stream.write(output.data(), output.size());
+
+        const auto now = search::GetCurrentTime();
+        if (now - last_report >= 10000) {
+          fmt::println("rescored {}/{} chunks, {} positions",
+                       chunk_index + 1,
+                       chunks.size(),
+                       positions.load(std::memory_order_relaxed));
+          std::cout.flush();
+          last_report = now;
+        }
+      });
+
+  output_stream.close();
+  if (!output_stream) {
+    fmt::println("Error: Failed to write output file {}", output_path);
+    return;
+  }
+
+  const auto elapsed = std::max<U64>(search::GetCurrentTime() - start_time, 1);
+  fmt::println("rescored {} games and {} positions into {} in {} ms "
+               "({:.0f} positions/s), {} games left out",
+               games.load(),
+               positions.load(),
+               output_path,
+               elapsed,
+               positions.load() / (elapsed / 1000.0),
+               skipped.load());
+}
+
+// Positions waiting to be shuffled, spread over files that each fit in memory
+class ShuffleBuckets {
+ public:
+  ShuffleBuckets(const std::string &output_prefix,
+                 U64 num_buckets,
+                 U64 buffer_records)
+      : buffers_(num_buckets), buffer_records_(buffer_records) {
+    for (U64 i = 0; i < num_buckets; i++) {
+      paths_.push_back(fmt::format("{}.bucket{}", output_prefix, i));
+      // Left over buckets of an earlier run would be appended to
+      std::filesystem::remove(paths_.back());
+    }
+  }
+
+  void Push(U64 bucket, const format::MarlinChessBoard &position) {
+    auto &buffer = buffers_[bucket];
+    buffer.push_back(position);
+    if (buffer.size() >= buffer_records_) Flush(bucket);
+  }
+
+  // Writes out what's left in the buffers and frees them
+  bool Finish() {
+    for (std::size_t i = 0; i < buffers_.size(); i++) Flush(i);
+    buffers_ = {};
+    return !failed_;
+  }
+
+  // Reads a bucket back into memory and deletes its file
+  std::vector<format::MarlinChessBoard> Take(U64 bucket) {
+    std::vector<format::MarlinChessBoard> positions;
+
+    std::error_code error;
+    const U64 size = std::filesystem::file_size(paths_[bucket], error);
+    if (!error) {
+      positions.resize(size / sizeof(format::MarlinChessBoard));
+      std::ifstream file(paths_[bucket], std::ios::binary);
+      file.read(reinterpret_cast<char *>(positions.data()),
+                positions.size() * sizeof(format::MarlinChessBoard));
+    }
+
+    std::filesystem::remove(paths_[bucket], error);
+    return positions;
+  }
+
+ private:
+  // Only one bucket file is open at a time, there can be more of them than the
+  // process may have open
+  void Flush(U64 bucket) {
+    auto &buffer = buffers_[bucket];
+    if (buffer.empty()) return;
+
+    std::ofstream file(paths_[bucket], std::ios::binary | std::ios::app);
+    file.write(reinterpret_cast<const char *>(buffer.data()),
+               buffer.size() * sizeof(format::MarlinChessBoard));
+    failed_ |= !file;
+    buffer.clear();
+  }
+
+ private:
+  std::vector<std::string> paths_;
+  std::vector<std::vector<format::MarlinChessBoard>> buffers_;
+  U64 buffer_records_;
+  bool failed_ = false;
+};
+
+void ShuffleBinPack(const std::string &path,
+                    const std::string &output_prefix,
+                    int num_shards,
+                    U64 memory_mb) {
+  constexpr U64 kRecordSize = sizeof(format::MarlinChessBoard);
+
+  const format::BinPackFile file(path);
+  if (!file.IsOpen()) {
+    fmt::println("Error: Failed to open binpack file {}", path);
+    return;
+  }
+
+  errors_reported = 0;
+  const auto start_time = search::GetCurrentTime();
+
+  U64 total_positions = 0;
+  const U64 trailing_bytes =
+      ForEachGame(file, [&](const format::BinPackGame &game, U64) {
+        total_positions += game.num_moves;
+      });
+  if (trailing_bytes > 0) {
+    fmt::println("Error: last {} bytes are a {}, which is left out",
+                 trailing_bytes,
+                 format::IsCompressedBinPack(file.Data(), file.Size())
+                     ? "cut off or corrupt block"
+                     : "game without its terminator");
+  }
+
+  // Half of the memory goes to the filter and the other half to the buckets,
+  // which are sized so that any one of them can be shuffled in memory
+  const U64 memory = std::max<U64>(memory_mb, 1) << 20;
+  const U64 bucket_memory = memory / 2;
+  const U64 num_buckets = std::max<U64>(
+      (total_positions * kRecordSize + bucket_memory - 1) / bucket_memory, 1);
+  const U64 buffer_records =
+      std::max<U64>(bucket_memory / num_buckets / kRecordSize, 1);
+
+  const U64 seed = std::random_device()();
+  std::mt19937_64 generator(seed);
+
+  fmt::println(
+      "deduplicating and shuffling {} positions of {} into {} shards through "
+      "{} buckets, seed {}",
+      total_positions,
+      path,
+      num_shards,
+      num_buckets,
+      seed);
+
+  // Positions are deduplicated by their zobrist key and scattered among the
+  // buckets at random, keeping the first occurrence of each
+  U64 unique_positions = 0, skipped_games = 0;
+  ShuffleBuckets buckets(output_prefix, num_buckets, buffer_records);
+  {
+    BloomFilter seen(memory - bucket_memory, total_positions);
+    Board board(BoardMode::kMovesOnly);
+
+    ForEachGame(file, [&](const format::BinPackGame &game, U64 offset) {
+      BoardState state;
+      if (!format::DecodeBoardState(game.board, state)) {
+        ++skipped_games;
+        ReportError(offset, "header doesn't describe a position");
+        return;
+      }
+      board.SetFromState(state);
+
+      for (U64 i = 0; i < game.num_moves; i++) {
+        const auto [move_data, score] = game.GetMove(i);
+        const auto &current = board.GetState();
+
+        if (!seen.Insert(current.zobrist_key)) {
+          auto position = format::BinPackFormatter::ConvertBoardState(current);
+          position.evaluation = score;
+          position.wdl_outcome = game.board.wdl_outcome;
+          buckets.Push(generator() % num_buckets, position);
+          ++unique_positions;
+        }
+
+        const Move move = format::DecodeMove(move_data);
+        if (!board.IsMovePseudoLegal(move) || !board.IsMoveLegal(move)) {
+          ++skipped_games;
+          ReportError(offset,
+                      "move {} is illegal, the rest of the game is left out",
+                      i + 1);
+          break;
+        }
+        board.MakeMove(move);
+      }
+    });
+
+    fmt::println("kept {} unique positions ({:.1f}% duplicates), an estimated "
+                 "{:.3f}% of them were dropped as false positives",
+                 unique_positions,
+                 100.0 * (total_positions - unique_positions) /
+                     std::max<U64>(total_positions, 1),
+                 100.0 * seen.FalsePositiveRate(unique_positions));
+  }
+
+  if (!buckets.Finish()) {
+    fmt::println("Error: Failed to write the buckets next to {}",
+                 output_prefix);
+    return;
+  }
+
+  std::vector<std::ofstream> shards;
+  for (int i = 0; i < num_shards; i++) {
+    const auto shard_path = fmt::format("{}.{}", output_prefix, i);
+    shards.emplace_back(shard_path, std::ios::binary | std::ios::trunc);
+    if (!shards.back()) {
+      fmt::println("Error: Failed to open output file {}", shard_path);
+      return;
+    }
+  }
+
+  // A bucket is a uniformly random sample of the positions, so shuffling each
+  // one and dealing it out evenly leaves every shard uniformly shuffled too
+  for (U64 i = 0; i < num_buckets; i++) {
+    auto positions = buckets.Take(i);
+    std::ranges::shuffle(positions, generator);
+
+    for (int shard = 0; shard < num_shards; shard++) {
+      const auto begin = positions.size() * shard / num_shards;
+      const auto end = positions.size() * (shard + 1) / num_shards;
+      shards[shard].write(
+          reinterpret_cast<const char *>(positions.data() + begin),
+          (end - begin) * kRecordSize);
+    }
+  }
+
+  for (auto &shard : shards) {
+    shard.close();
+    if (!shard) {
+      fmt::println("Error: Failed to write the shards of {}", output_prefix);
+      return;
+    }
+  }
+
+  fmt::println("wrote {} shards of about {} positions in {} ms, {} games had "
+               "errors",
+               num_shards,
+               unique_positions / num_shards,
+               search::GetCurrentTime() - start_time,
+               skipped_games);
+}
+
+void CompressBinPack(const std::string &input_path,
+                     const std::string &output_path,
+                     int num_threads) {
+  const format::BinPackFile file(input_path);
+  if (!file.IsOpen()) {
+    fmt::println("Error: Failed to open binpack file {}", input_path);
+    return;
+  }
+
+  if (format::IsCompressedBinPack(file.Data(), file.Size())) {
+    fmt::println("Error: {} is already compressed", input_path);
+    return;
+  }
+
+  std::ofstream output_stream(output_path, std::ios::binary | std::ios::trunc);
+  if (!output_stream) {
+    fmt::println("Error: Failed to open output file {}", output_path);
+    return;
+  }
+
+  fmt::println("compressing {} on {} threads", input_path, num_threads);
+
+  // Every chunk of whole games becomes one block
+  U64 trailing_bytes = 0;
+  const auto chunks =
+      SplitIntoChunks(file, format::kDefaultBlockSize, trailing_bytes);
+  if (trailing_bytes > 0) {
+    fmt::println("Error: last {} bytes are a game without its terminator, "
+                 "which is left out",
+                 trailing_bytes);
+  }
+
+  const auto start_time = search::GetCurrentTime();
+  format::WriteFileHeader(output_stream);
+  U64 bytes_written = format::kFileHeaderSize;
+
+  ProcessChunksInOrder(
+      chunks.size(),
+      num_threads,
+      [&]() {
+        return [&](std::size_t chunk_index, std::string &output) {
+          const auto &chunk = chunks[chunk_index];
+          format::CompressBlock(
+              file.Data() + chunk.begin, chunk.end - chunk.begin, output);
+        };
+      },
+      [&](std::size_t, const std::string &output) {
+        output_stream.write(output.data(), output.size());
+        bytes_written += output.size();
+      });
+
+  output_stream.close();
+  if (!output_stream) {
+    fmt::println("Error: Failed to write output file {}", output_path);
+    return;
+  }
+
+  const U64 raw_bytes = file.Size() - trailing_bytes;
+  const auto elapsed = std::max<U64>(search::GetCurrentTime() - start_time, 1);
+  fmt::println("compressed {:.1f} MB into {:.1f} MB ({:.3f}x) in {} blocks "
+               "in {} ms ({:.0f} MB/s)",
+               raw_bytes / (1024.0 * 1024.0),
+               bytes_written / (1024.0 * 1024.0),
+               static_cast<double>(raw_bytes) / std::max<U64>(bytes_written, 1),
+               chunks.size(),
+               elapsed,
+               raw_bytes / (1024.0 * 1024.0) / (elapsed / 1000.0));
+}
+
+void DecompressBinPack(const std::string &input_path,
+                       const std::string &output_path,
+                       int num_threads) {
+  const format::BinPackFile file(input_path);
+  if (!file.IsOpen()) {
+    fmt::println("Error: Failed to open binpack file {}", input_path);
+    return;
+  }
+
+  if (!format::IsCompressedBinPack(file.Data(), file.Size())) {
+    fmt::println("Error: {} isn't compressed", input_path);
+    return;
+  }
+
+  std::ofstream output_stream(output_path, std::ios::binary | std::ios::trunc);
+  if (!output_stream) {
+    fmt::println("Error: Failed to open output file {}", output_path);
+    return;
+  }
+
+  fmt::println("decompressing {} on {} threads", input_path, num_threads);
+
+  errors_reported = 0;
+
+  U64 trailing_bytes = 0;
+  const auto chunks = SplitIntoBlocks(file, trailing_bytes);
+  if (trailing_bytes > 0) {
+    fmt::println("Error: last {} bytes are a cut off or corrupt block, "
+                 "which is left out",
+                 trailing_bytes);
+  }
+
+  const auto start_time = search::GetCurrentTime();
+  U64 bytes_written = 0;
+  std::atomic<U64> corrupt_blocks = 0;
+
+  const auto make_decompressor = [&]() {
+    return [&, decompressor = format::BlockDecompressor()](
+               std::size_t chunk_index, std::string &output) mutable {
+      const auto &chunk = chunks[chunk_index];
+      format::BlockReader blocks(file.Data() + chunk.begin,
+                                 file.Data() + chunk.end);
+      format::CompressedBlock block;
+      if (!blocks.Next(block) || !decompressor.Decompress(block)) {
+        corrupt_blocks.fetch_add(1, std::memory_order_relaxed);
+        ReportCorruptBlock(chunk.begin);
+        return;
+      }
+      output.append(decompressor.Data(), decompressor.Size());
+    };
+  };
+
+  ProcessChunksInOrder(chunks.size(),
+                       num_threads,
+                       make_decompressor,
+                       [&](std::size_t, const std::string &output) {
+                         output_stream.write(output.data(), output.size());
+                         bytes_written += output.size();
+                       });
+
+  output_stream.close();
+  if (!output_stream) {
+    fmt::println("Error: Failed to write output file {}", output_path);
+    return;
+  }
+
+  const auto elapsed = std::max<U64>(search::GetCurrentTime() - start_time, 1);
+  fmt::println("decompressed {} blocks into {:.1f} MB in {} ms ({:.0f} MB/s), "
+               "{} corrupt blocks left out",
+               chunks.size(),
+               bytes_written / (1024.0 * 1024.0),
+               elapsed,
+               bytes_written / (1024.0 * 1024.0) / (elapsed / 1000.0),
+               corrupt_blocks.load());
+}
+
+}  // namespace data_gen
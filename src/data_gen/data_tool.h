@@ -0,0 +1,48 @@
+#ifndef INTEGRAL_DATA_TOOL_H
+#define INTEGRAL_DATA_TOOL_H
+
+#include <string>
+
+#include "../utils/types.h"
+
+// Tools that work on the binpack files written by data generation, so that a
+// dataset can be checked and relabeled before it's used for training
+namespace data_gen {
+
+// Replays every game of a binpack file on the given number of threads,
+// reporting anything a trainer couldn't read back along with statistics of the
+// games and positions
+void ValidateBinPack(const std::string &path, int num_threads);
+
+// Writes a copy of a binpack file with every position scored again by the
+// static evaluation, or by a search of the given number of nodes. The games
+// are rescored in parallel but keep their order, and a compressed file is
+// written back out plain
+void RescoreBinPack(const std::string &input_path,
+                    const std::string &output_path,
+                    int num_threads,
+                    U64 nodes);
+
+// Deduplicates the positions of a binpack file by their zobrist keys and
+// shuffles them into shards of single position records, using about the given
+// amount of memory however large the file is
+void ShuffleBinPack(const std::string &path,
+                    const std::string &output_prefix,
+                    int num_shards,
+                    U64 memory_mb);
+
+// Converts a binpack file into one made of independently compressed blocks of
+// whole games, compressing the blocks in parallel
+void CompressBinPack(const std::string &input_path,
+                     const std::string &output_path,
+                     int num_threads);
+
+// Converts a compressed binpack file back into a plain one, decompressing the
+// blocks in parallel
+void DecompressBinPack(const std::string &input_path,
+                       const std::string &output_path,
+                       int num_threads);
+
+}  // namespace data_gen
+
+#endif  // INTEGRAL_DATA_TOOL_H
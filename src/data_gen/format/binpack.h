@@ -128,7 +128,8 @@ class BinPackFormatter : public OutputFormatter {
     return moves_.size();
   }
 
- private:
+  // Packs a position into a game header, which on its own is also a record of
+  // a single position once its evaluation and outcome are filled in
   static MarlinChessBoard ConvertBoardState(const BoardState& state) {
     MarlinChessBoard converted{.occupied = state.Occupied().AsU64()};
 
@@ -0,0 +1,239 @@
+#ifndef INTEGRAL_BINPACK_READER_H
+#define INTEGRAL_BINPACK_READER_H
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "binpack.h"
+
+#if defined(__unix__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace data_gen::format {
+
+// Read-only view of a whole binpack file. The file is memory mapped where the
+// platform allows it, and read into memory otherwise
+class BinPackFile {
+ public:
+  explicit BinPackFile(const std::string &path) : data_(nullptr), size_(0) {
+#if defined(__unix__)
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) return;
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == 0) {
+      size_ = file_stat.st_size;
+      open_ = true;
+      if (size_ > 0) {
+        void *mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+          // Every reader streams through its part of the file front to back
+          madvise(mapping, size_, MADV_SEQUENTIAL);
+          data_ = static_cast<const char *>(mapping);
+        } else {
+          open_ = false;
+        }
+      }
+    }
+    close(fd);
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return;
+
+    buffer_.resize(file.tellg());
+    file.seekg(0);
+    open_ = static_cast<bool>(file.read(buffer_.data(), buffer_.size()));
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+#endif
+  }
+
+  ~BinPackFile() {
+#if defined(__unix__)
+    if (data_) munmap(const_cast<char *>(data_), size_);
+#endif
+  }
+
+  BinPackFile(const BinPackFile &) = delete;
+  BinPackFile &operator=(const BinPackFile &) = delete;
+
+  [[nodiscard]] bool IsOpen() const {
+    return open_;
+  }
+
+  [[nodiscard]] const char *Data() const {
+    return data_;
+  }
+
+  [[nodiscard]] U64 Size() const {
+    return size_;
+  }
+
+ private:
+  const char *data_;
+  U64 size_;
+  bool open_ = false;
+#if !defined(__unix__)
+  std::vector<char> buffer_;
+#endif
+};
+
+// A game as stored in the file, with its moves pointing into the file's data
+struct BinPackGame {
+  MarlinChessBoard board;
+  const char *moves;
+  U64 num_moves;
+  // Byte offset of the game's header from the start of the scanned range
+  U64 offset;
+
+  [[nodiscard]] BinPackMove GetMove(U64 i) const {
+    // BinPackMove is a std::pair, which isn't trivially copyable, so its
+    // fields are copied out one at a time
+    const char *data = moves + i * sizeof(BinPackMove);
+    BinPackMove move;
+    std::memcpy(&move.first, data, sizeof(move.first));
+    std::memcpy(&move.second, data + sizeof(move.first), sizeof(move.second));
+    return move;
+  }
+};
+
+// Streams the games of a byte range of a binpack file. Every game is a board
+// header followed by its moves and a null move terminator, so a game can only
+// be found by walking all the games before it
+class BinPackReader {
+ public:
+  BinPackReader(const char *begin, const char *end)
+      : begin_(begin), current_(begin), end_(end) {}
+
+  // Reads the next whole game, returning false at the end of the range or at a
+  // game that is cut off before its terminator
+  bool Next(BinPackGame &game) {
+    if (end_ - current_ < static_cast<std::ptrdiff_t>(sizeof(game.board))) {
+      return false;
+    }
+
+    const char *moves = current_ + sizeof(game.board);
+    const char *move = moves;
+    while (end_ - move >= static_cast<std::ptrdiff_t>(sizeof(BinPackMove))) {
+      // The terminator is the only move with all bits clear
+      U32 raw_move;
+      std::memcpy(&raw_move, move, sizeof(raw_move));
+      if (raw_move == 0) {
+        std::memcpy(&game.board, current_, sizeof(game.board));
+        game.moves = moves;
+        game.num_moves = (move - moves) / sizeof(BinPackMove);
+        game.offset = current_ - begin_;
+        current_ = move + sizeof(BinPackMove);
+        return true;
+      }
+      move += sizeof(BinPackMove);
+    }
+
+    return false;
+  }
+
+  // Bytes past the last whole game, which belong to a cut off game once Next()
+  // has returned false
+  [[nodiscard]] U64 Remaining() const {
+    return end_ - current_;
+  }
+
+  [[nodiscard]] U64 Offset() const {
+    return current_ - begin_;
+  }
+
+ private:
+  const char *begin_;
+  const char *current_;
+  const char *end_;
+};
+
+static_assert(sizeof(BinPackMove) == sizeof(U32));
+
+// Rebuilds the position stored in a game header, the inverse of what
+// BinPackFormatter writes. Returns false if the header can't be a position
+inline bool DecodeBoardState(const MarlinChessBoard &board,
+                             BoardState &state) {
+  constexpr U8 kUnmovedRookPieceId = 6;
+
+  state = BoardState();
+
+  int i = 0;
+  for (Square square : BitBoard(board.occupied)) {
+    if (i == 32) return false;
+
+    const U8 piece_id = board.pieces[i++] & 0xF;
+    const auto color = piece_id & 0b1000 ? Color::kBlack : Color::kWhite;
+    const U8 type_id = piece_id & 0b0111;
+    if (type_id > kUnmovedRookPieceId) return false;
+
+    if (type_id == kUnmovedRookPieceId) {
+      // The castling rights are carried by the rooks that haven't moved
+      const int home_rank = color == Color::kWhite ? 0 : 7;
+      if (square.Rank() != home_rank) return false;
+      if (square.File() == 0) {
+        state.castle_rights.SetCanQueensideCastle(color, true);
+      } else if (square.File() == 7) {
+        state.castle_rights.SetCanKingsideCastle(color, true);
+      } else {
+        return false;
+      }
+      state.PlacePiece(square, PieceType::kRook, color);
+    } else {
+      state.PlacePiece(square, static_cast<PieceType>(type_id), color);
+    }
+  }
+
+  state.turn = board.turn_and_en_passant & 0b10000000 ? Color::kBlack
+                                                      : Color::kWhite;
+  if (state.turn == Color::kBlack) {
+    state.zobrist_key ^= zobrist::turn;
+  }
+  state.zobrist_key ^= zobrist::castle_rights[state.castle_rights.AsU8()];
+
+  const U8 en_passant = board.turn_and_en_passant & 0b01111111;
+  if (en_passant > Squares::kNoSquare) return false;
+  if (en_passant != Squares::kNoSquare) {
+    state.en_passant = en_passant;
+    state.zobrist_key ^= zobrist::en_passant[state.en_passant.File()];
+  }
+
+  state.fifty_moves_clock = board.half_move_clock;
+  // Written as (half_moves + 1) / 2, which only loses the side to move
+  state.half_moves =
+      board.full_move_number * 2 - (state.turn == Color::kBlack ? 1 : 0);
+
+  return state.King(Color::kWhite).PopCount() == 1 &&
+         state.King(Color::kBlack).PopCount() == 1;
+}
+
+// Converts a stored move back into the engine's representation, where castles
+// move the king two squares instead of onto the rook
+inline Move DecodeMove(U16 move_data) {
+  const Square from = move_data & 0x3F;
+  Square to = (move_data >> 6) & 0x3F;
+
+  switch (move_data & 0xC000) {
+    case kBinPackMoveTypes[static_cast<int>(MoveType::kPromotion)]:
+      return Move(from,
+                  to,
+                  static_cast<PromotionType>((move_data >> 12) & 0b11));
+    case kBinPackMoveTypes[static_cast<int>(MoveType::kCastle)]:
+      to = to.File() > from.File() ? to - 1 : to + 2;
+      return Move(from, to, MoveType::kCastle);
+    case kBinPackMoveTypes[static_cast<int>(MoveType::kEnPassant)]:
+      return Move(from, to, MoveType::kEnPassant);
+    default:
+      return Move(from, to);
+  }
+}
+
+}  // namespace data_gen::format
+
+#endif  // INTEGRAL_BINPACK_READER_H
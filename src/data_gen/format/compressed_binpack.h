@@ -0,0 +1,211 @@
+#ifndef INTEGRAL_COMPRESSED_BINPACK_H
+#define INTEGRAL_COMPRESSED_BINPACK_H
+
+#include <lz4block.h>
+
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "../../utils/types.h"
+
+// A compressed binpack file is a file header followed by a sequence of
+// independent blocks, each holding the LZ4 compressed bytes of whole games. Any
+// block can be decompressed without the ones before it, so a file can be read
+// on many threads, and a file cut off mid-block only loses its last block
+namespace data_gen::format {
+
+// Every compressed file starts with this magic. A plain binpack starts with the
+// occupancy of a position, which has at most 32 bits set, while the magic has
+// 43 of them set, so the two can never be mistaken for each other
+constexpr U64 kFileMagic = 0xFFFFFFFF5A504249;  // "IBPZ" and four 0xFF bytes
+constexpr U64 kFileHeaderSize = sizeof(kFileMagic);
+
+constexpr U32 kBlockMagic = 0x4B4C4249;  // "IBLK"
+
+// Games are gathered into blocks of about this many bytes before compressing
+constexpr U32 kDefaultBlockSize = 1 << 20;
+
+// Larger sizes can only come from a corrupt header
+constexpr U32 kMaxBlockSize = 1 << 28;
+
+enum BlockFlags : U32 {
+  // The payload is the games as they are, since compressing didn't help
+  kStoredBlock = 1 << 0,
+  // The bytes were grouped by their position within each 4-byte word before
+  // compressing, see ShuffleBytes()
+  kShuffledBlock = 1 << 1,
+};
+
+struct BlockHeader {
+  U32 magic;
+  U32 flags;
+  U32 raw_size;
+  U32 compressed_size;
+};
+
+static_assert(sizeof(BlockHeader) == 16);
+
+// Whether the data starts with the header of a compressed file rather than
+// with a game
+inline bool IsCompressedBinPack(const char *data, U64 size) {
+  U64 magic = 0;
+  if (size >= sizeof(magic)) std::memcpy(&magic, data, sizeof(magic));
+  return magic == kFileMagic;
+}
+
+inline void WriteFileHeader(std::ostream &output) {
+  output.write(reinterpret_cast<const char *>(&kFileMagic), sizeof(kFileMagic));
+}
+
+// Groups the bytes of every 4-byte word by their position within the word.
+// Headers and moves are both whole words, so this gathers the move flags and
+// the mostly empty high bytes of the scores into runs that LZ4 can match,
+// which it otherwise barely finds in binpack data
+inline void ShuffleBytes(const char *input, char *output, U64 size) {
+  const U64 words = size / 4;
+  for (U64 i = 0; i < words; i++) {
+    for (U64 lane = 0; lane < 4; lane++) {
+      output[lane * words + i] = input[i * 4 + lane];
+    }
+  }
+  std::memcpy(output + words * 4, input + words * 4, size - words * 4);
+}
+
+inline void UnshuffleBytes(const char *input, char *output, U64 size) {
+  const U64 words = size / 4;
+  for (U64 i = 0; i < words; i++) {
+    for (U64 lane = 0; lane < 4; lane++) {
+      output[i * 4 + lane] = input[lane * words + i];
+    }
+  }
+  std::memcpy(output + words * 4, input + words * 4, size - words * 4);
+}
+
+// Appends the data, which must be whole games, to the output as one block
+inline void CompressBlock(const char *data, U32 size, std::string &output) {
+  std::vector<char> shuffled(size);
+  ShuffleBytes(data, shuffled.data(), size);
+
+  const int bound = lz4block_compress_bound(size);
+  const U64 header_offset = output.size();
+  output.resize(header_offset + sizeof(BlockHeader) + bound);
+
+  char *payload = output.data() + header_offset + sizeof(BlockHeader);
+  const int compressed_size =
+      lz4block_compress(shuffled.data(), payload, size, bound);
+
+  BlockHeader header{kBlockMagic, kShuffledBlock, size, 0};
+  if (compressed_size > 0 && static_cast<U32>(compressed_size) < size) {
+    header.compressed_size = compressed_size;
+  } else {
+    header.flags = kStoredBlock;
+    header.compressed_size = size;
+    std::memcpy(payload, data, size);
+  }
+
+  std::memcpy(output.data() + header_offset, &header, sizeof(header));
+  output.resize(header_offset + sizeof(header) + header.compressed_size);
+}
+
+// A block as stored in the file, with its payload pointing into the file's
+// data
+struct CompressedBlock {
+  BlockHeader header;
+  const char *payload;
+  // Byte offset of the block's header from the start of the scanned range
+  U64 offset;
+
+  [[nodiscard]] U64 StoredSize() const {
+    return sizeof(header) + header.compressed_size;
+  }
+};
+
+// Walks the blocks of a byte range of a compressed binpack file. Only the
+// headers are read, so finding every block is much faster than decompressing
+class BlockReader {
+ public:
+  BlockReader(const char *begin, const char *end)
+      : begin_(begin), current_(begin), end_(end) {}
+
+  // Reads the next block, returning false at the end of the range or at a
+  // block that is cut off or whose header is corrupt
+  bool Next(CompressedBlock &block) {
+    if (end_ - current_ < static_cast<std::ptrdiff_t>(sizeof(block.header))) {
+      return false;
+    }
+
+    std::memcpy(&block.header, current_, sizeof(block.header));
+    const auto &header = block.header;
+    if (header.magic != kBlockMagic || header.raw_size > kMaxBlockSize ||
+        header.compressed_size > kMaxBlockSize) {
+      return false;
+    }
+
+    if (static_cast<U64>(end_ - current_) < block.StoredSize()) return false;
+
+    block.payload = current_ + sizeof(block.header);
+    block.offset = current_ - begin_;
+    current_ += block.StoredSize();
+    return true;
+  }
+
+  // Bytes past the last whole block, which are corrupt or cut off once Next()
+  // has returned false
+  [[nodiscard]] U64 Remaining() const {
+    return end_ - current_;
+  }
+
+  [[nodiscard]] U64 Offset() const {
+    return current_ - begin_;
+  }
+
+ private:
+  const char *begin_;
+  const char *current_;
+  const char *end_;
+};
+
+// Decompresses blocks into a buffer that is reused from one block to the next
+class BlockDecompressor {
+ public:
+  // Returns false if the block's payload is corrupt
+  bool Decompress(const CompressedBlock &block) {
+    const auto &header = block.header;
+    const U32 size = header.raw_size;
+
+    if (header.flags == kStoredBlock) {
+      if (header.compressed_size != size) return false;
+      data_.assign(block.payload, block.payload + size);
+      return true;
+    }
+
+    if (header.flags != kShuffledBlock) return false;
+
+    scratch_.resize(size);
+    const int decompressed_size = lz4block_decompress(
+        block.payload, scratch_.data(), header.compressed_size, size);
+    if (decompressed_size != static_cast<int>(size)) return false;
+
+    data_.resize(size);
+    UnshuffleBytes(scratch_.data(), data_.data(), size);
+    return true;
+  }
+
+  [[nodiscard]] const char *Data() const {
+    return data_.data();
+  }
+
+  [[nodiscard]] U64 Size() const {
+    return data_.size();
+  }
+
+ private:
+  std::vector<char> data_;
+  std::vector<char> scratch_;
+};
+
+}  // namespace data_gen::format
+
+#endif  // INTEGRAL_COMPRESSED_BINPACK_H
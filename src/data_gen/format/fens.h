@@ -8,10 +8,10 @@ namespace data_gen::format {
 class FenFormatter : public OutputFormatter {
  public:
   explicit FenFormatter(std::ostream& output_stream)
-      : output_stream_(output_stream) {}
+      : start_pos_(BoardMode::kMovesOnly), output_stream_(output_stream) {}
 
   void SetPosition(const BoardState& state) override {
-    start_pos_ = Board(state);
+    start_pos_.SetFromState(state);
     fens_.clear();
   }
 
@@ -0,0 +1,210 @@
+#ifndef INTEGRAL_GAME_WRITER_H
+#define INTEGRAL_GAME_WRITER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../utils/types.h"
+#include "format/compressed_binpack.h"
+
+namespace data_gen {
+
+struct EncodedGame {
+  std::string data;
+  U64 positions = 0;
+};
+
+// Games, positions and bytes that have made it into the output file
+struct WriterTotals {
+  U64 games = 0;
+  U64 positions = 0;
+  U64 bytes = 0;
+};
+
+// Single-producer single-consumer ring of encoded games, which lets a game
+// thread hand its games to the writer without taking a lock
+class GameQueue {
+ public:
+  static constexpr std::size_t kCapacity = 64;
+
+  GameQueue() : head_(0), tail_(0) {}
+
+  bool TryPush(EncodedGame &game) {
+    const auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == kCapacity) {
+      return false;
+    }
+
+    slots_[tail % kCapacity] = std::move(game);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  std::optional<EncodedGame> TryPop() {
+    const auto head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      return std::nullopt;
+    }
+
+    auto game = std::move(slots_[head % kCapacity]);
+    head_.store(head + 1, std::memory_order_release);
+    return game;
+  }
+
+ private:
+  std::array<EncodedGame, kCapacity> slots_;
+  alignas(64) std::atomic<std::size_t> head_;
+  alignas(64) std::atomic<std::size_t> tail_;
+};
+
+// Streams the games of every game thread into one output file as soon as they
+// complete, so that nothing needs to be concatenated afterwards and a crash
+// only loses the games still in flight. Every game is written whole, or as
+// part of a compressed block of whole games when a block size is given
+class GameWriter {
+ public:
+  GameWriter(std::ostream &output_stream,
+             int num_producers,
+             const WriterTotals &initial_totals = {},
+             U32 block_size = 0)
+      : output_stream_(output_stream),
+        totals_(initial_totals),
+        block_size_(block_size),
+        events_(0),
+        done_(false) {
+    queues_.reserve(num_producers);
+    for (int i = 0; i < num_producers; i++) {
+      queues_.push_back(std::make_unique<GameQueue>());
+    }
+
+    // A compressed file that is resumed already has its header
+    if (block_size_ > 0 && totals_.bytes == 0) {
+      format::WriteFileHeader(output_stream_);
+      totals_.bytes += format::kFileHeaderSize;
+    }
+  }
+
+  // Calls the callback from the writer thread with the totals written so far,
+  // at most once per interval and once more after the last game
+  void SetCheckpoint(std::chrono::milliseconds interval,
+                     std::function<void(const WriterTotals &)> callback) {
+    checkpoint_interval_ = interval;
+    checkpoint_callback_ = std::move(callback);
+  }
+
+  // Hands over an encoded game from the given producer, waiting for the writer
+  // to catch up if the producer's queue is full
+  void Push(int producer, EncodedGame game) {
+    while (!queues_[producer]->TryPush(game)) {
+      std::this_thread::yield();
+    }
+    Notify();
+  }
+
+  // Writes games until Finish() is called and every queue has been drained
+  void Run() {
+    auto last_checkpoint = std::chrono::steady_clock::now();
+
+    while (true) {
+      // Anything pushed after these loads bumps the event count, so the wait
+      // below can't miss it
+      const bool done = done_.load(std::memory_order_acquire);
+      const U64 events = events_.load(std::memory_order_acquire);
+
+      bool wrote = false;
+      for (auto &queue : queues_) {
+        while (auto game = queue->TryPop()) {
+          if (block_size_ > 0) {
+            block_ += game->data;
+            ++block_totals_.games;
+            block_totals_.positions += game->positions;
+            if (block_.size() >= block_size_) wrote |= WriteBlock();
+            continue;
+          }
+
+          output_stream_.write(game->data.data(), game->data.size());
+          ++totals_.games;
+          totals_.positions += game->positions;
+          totals_.bytes += game->data.size();
+          wrote = true;
+        }
+      }
+
+      // A checkpoint has to cover every game popped so far, so it writes out
+      // the block being gathered even if it isn't full yet
+      const auto now = std::chrono::steady_clock::now();
+      const bool checkpoint =
+          done || (checkpoint_callback_ &&
+                   now - last_checkpoint >= checkpoint_interval_);
+      if (checkpoint) wrote |= WriteBlock();
+
+      // Flush once per batch, so the file always ends on a whole game unless
+      // the process dies mid-write
+      if (wrote) output_stream_.flush();
+
+      if (checkpoint_callback_ && checkpoint) {
+        checkpoint_callback_(totals_);
+        last_checkpoint = now;
+      }
+
+      if (done) break;
+      events_.wait(events, std::memory_order_acquire);
+    }
+  }
+
+  // Lets Run() return once all the games pushed so far have been written
+  void Finish() {
+    done_.store(true, std::memory_order_release);
+    Notify();
+  }
+
+ private:
+  void Notify() {
+    events_.fetch_add(1, std::memory_order_release);
+    events_.notify_one();
+  }
+
+  // Compresses the games gathered so far into one block, returning whether
+  // there were any to write
+  bool WriteBlock() {
+    if (block_.empty()) return false;
+
+    compressed_.clear();
+    format::CompressBlock(block_.data(), block_.size(), compressed_);
+    output_stream_.write(compressed_.data(), compressed_.size());
+
+    totals_.games += block_totals_.games;
+    totals_.positions += block_totals_.positions;
+    totals_.bytes += compressed_.size();
+
+    block_.clear();
+    block_totals_ = {};
+    return true;
+  }
+
+ private:
+  std::ostream &output_stream_;
+  std::vector<std::unique_ptr<GameQueue>> queues_;
+  WriterTotals totals_;
+  U32 block_size_;
+  // Games waiting to be compressed, which aren't part of the totals yet
+  std::string block_, compressed_;
+  WriterTotals block_totals_;
+  std::chrono::milliseconds checkpoint_interval_{};
+  std::function<void(const WriterTotals &)> checkpoint_callback_;
+  // Bumped on every push, which the writer sleeps on while idle
+  std::atomic<U64> events_;
+  std::atomic_bool done_;
+};
+
+}  // namespace data_gen
+
+#endif  // INTEGRAL_GAME_WRITER_H
@@ -1,5 +1,6 @@
 #include "evaluation.h"
 
+#include "../../utils/timers.h"
 #include "nnue/nnue.h"
 
 namespace eval {
@@ -9,6 +10,8 @@ Score Evaluate(Board &board) {
 }
 
 bool StaticExchange(Move move, int threshold, const BoardState &state) {
+  SCOPED_TIMER(kStaticExchange);
+
   const auto from = move.GetFrom();
   const auto to = move.GetTo();
 
@@ -2,6 +2,7 @@
 #define INTEGRAL_ACCUMULATOR_H
 
 #include "../../../chess/board.h"
+#include "../../../utils/timers.h"
 #include "arch.h"
 #include "nnue.h"
 
@@ -171,6 +172,8 @@ class Accumulator {
   }
 
   void MakeMove(const BoardState& state, Move move) {
+    SCOPED_TIMER(kAccumulatorMakeMove);
+
     // Don't make any changes in a null move
     if (!move) {
       return;
@@ -1,5 +1,6 @@
 #include "nnue.h"
 
+#include "../../../utils/timers.h"
 #include "accumulator.h"
 #include "arch.h"
 
@@ -56,6 +57,9 @@ void LoadFromIncBin() {
 
 Score Evaluate(const BoardState& state,
                std::shared_ptr<Accumulator>& accumulator) {
+  SCOPED_TIMER(kEvaluate);
+  assert(accumulator);
+
   const auto turn = state.turn;
   const auto bucket = accumulator->GetOutputBucket(state);
 
@@ -1,8 +1,11 @@
 #ifndef INTEGRAL_BONUS_H
 #define INTEGRAL_BONUS_H
 
+#include <limits>
+
 #include "../../../tuner/spsa.h"
 #include "../../../utils/types.h"
+#include "history_score.h"
 
 namespace search::history {
 
@@ -25,6 +28,13 @@ static int ScaleBonus(I32 score,
   return bonus - score * std::abs(bonus) / gravity;
 }
 
+// Applies the bonus to the score, which is clamped for gravities that exceed
+// the range of the compact score type
+static HistoryScore ApplyBonus(HistoryScore score, int bonus) {
+  constexpr int kMaxScore = std::numeric_limits<HistoryScore>::max();
+  return std::clamp(score + ScaleBonus(score, bonus), -kMaxScore, kMaxScore);
+}
+
 }  // namespace search::history
 
 #endif  // INTEGRAL_BONUS_H
\ No newline at end of file
@@ -11,11 +11,16 @@ class CaptureHistory {
  public:
   CaptureHistory() : table_({}) {}
 
+  void Clear() {
+    ClearMultiArray(table_);
+  }
+
   void UpdateScore(const BoardState &state, StackEntry *stack, int depth) {
     const int bonus = HistoryBonus(depth);
     // Apply a linear dampening to the bonus as the depth increases
-    int &score = table_[state.turn][stack->move.GetFrom()][stack->move.GetTo()];
-    score += ScaleBonus(score, bonus);
+    auto &score =
+        table_[state.turn][stack->move.GetFrom()][stack->move.GetTo()];
+    score = ApplyBonus(score, bonus);
   }
 
   void Penalize(const BoardState &state, int depth, MoveList &captures) {
@@ -24,9 +29,9 @@ class CaptureHistory {
     for (int i = 0; i < captures.Size(); i++) {
       const Move bad_capture = captures[i];
       // Apply a linear dampening to the penalty as the depth increases
-      int &bad_capture_score =
+      auto &bad_capture_score =
           table_[state.turn][bad_capture.GetFrom()][bad_capture.GetTo()];
-      bad_capture_score += ScaleBonus(bad_capture_score, -bonus);
+      bad_capture_score = ApplyBonus(bad_capture_score, -bonus);
     }
   }
 
@@ -35,7 +40,7 @@ class CaptureHistory {
   }
 
  private:
-  MultiArray<int, kNumColors, kSquareCount, kSquareCount> table_;
+  MultiArray<HistoryScore, kNumColors, kSquareCount, kSquareCount> table_;
 };
 
 }  // namespace search::history
@@ -1,19 +1,24 @@
 #ifndef INTEGRAL_CONTINUATION_HISTORY_H
 #define INTEGRAL_CONTINUATION_HISTORY_H
 
+#include <atomic>
+
 #include "../../../utils/multi_array.h"
 #include "../stack.h"
 #include "bonus.h"
 
 namespace search::history {
 
-using ContinuationEntry =
-    MultiArray<I32, kNumColors, kNumPieceTypes, kSquareCount>;
-
+// Can be shared between threads, in which case updates race but each score
+// stays bounded by the history gravity
 class ContinuationHistory {
  public:
   ContinuationHistory() : table_({}) {}
 
+  void Clear() {
+    ClearMultiArray(table_);
+  }
+
   void UpdateScore(const BoardState &state,
                    StackEntry *stack,
                    int depth,
@@ -50,9 +55,17 @@ class ContinuationHistory {
     const int piece = state.GetPieceType(move.GetFrom());
     const int to = move.GetTo();
 
-    auto &entry =
-        *reinterpret_cast<ContinuationEntry *>(stack->continuation_entry);
-    return entry[state.turn][piece][to];
+    auto &entry = *stack->continuation_entry;
+    return LoadHistoryScore(entry[state.turn][piece][to]);
+  }
+
+  // Returns the scores of the moves following the one at this ply, or zeros
+  // when there is none, so that batches of moves are scored without branching
+  [[nodiscard]] static const ContinuationScores &GetScores(Color turn,
+                                                           StackEntry *stack) {
+    static constexpr ContinuationScores kNoScores = {};
+    return stack->continuation_entry ? (*stack->continuation_entry)[turn]
+                                     : kNoScores;
   }
 
  private:
@@ -67,11 +80,11 @@ class ContinuationHistory {
     const int piece = state.GetPieceType(move.GetFrom());
     const int to = move.GetTo();
 
-    auto &entry =
-        *reinterpret_cast<ContinuationEntry *>(stack->continuation_entry);
+    auto &entry = *stack->continuation_entry;
 
-    int &score = entry[state.turn][piece][to];
-    score += ScaleBonus(score, bonus);
+    std::atomic_ref score(entry[state.turn][piece][to]);
+    score.store(ApplyBonus(score.load(std::memory_order_relaxed), bonus),
+                std::memory_order_relaxed);
   }
 
  private:
@@ -1,6 +1,8 @@
 #ifndef INTEGRAL_CORRECTION_HISTORY_H
 #define INTEGRAL_CORRECTION_HISTORY_H
 
+#include <atomic>
+
 #include "../../../tuner/spsa.h"
 #include "../../../utils/multi_array.h"
 #include "../stack.h"
@@ -10,10 +12,17 @@ namespace search::history {
 inline Tunable corr_history_scale("corr_history_scale", 256, 100, 500, 15);
 inline Tunable max_corr_hist("max_corr_hist", 64, 16, 128, 6);
 
+// Can be shared between threads, in which case updates race but each score
+// stays clamped to the maximum correction
 class CorrectionHistory {
  public:
   CorrectionHistory() : non_pawn_table_({}), pawn_table_({}) {}
 
+  void Clear() {
+    ClearMultiArray(pawn_table_);
+    ClearMultiArray(non_pawn_table_);
+  }
+
   void UpdateScore(const BoardState &state,
                    StackEntry *stack,
                    Score search_score,
@@ -29,29 +38,47 @@ class CorrectionHistory {
         CalculateScaledBonus(stack->static_eval, search_score);
 
     // Update pawn table score
-    auto &pawn_table_score = pawn_table_[state.turn][GetPawnTableIndex(state)];
-    pawn_table_score = UpdateTableScore(pawn_table_score, weight, scaled_bonus);
+    std::atomic_ref pawn_table_score(
+        pawn_table_[state.turn][GetPawnTableIndex(state)]);
+    pawn_table_score.store(
+        UpdateTableScore(pawn_table_score.load(std::memory_order_relaxed),
+                         weight,
+                         scaled_bonus),
+        std::memory_order_relaxed);
 
     // Update non-pawn table scores for both colors
     for (Color color : {Color::kWhite, Color::kBlack}) {
-      auto &non_pawn_table_score =
+      std::atomic_ref non_pawn_table_score(
           non_pawn_table_[state.turn][color]
-                         [GetNonPawnTableIndex(state, color)];
-      non_pawn_table_score =
-          UpdateTableScore(non_pawn_table_score, weight, scaled_bonus);
+                         [GetNonPawnTableIndex(state, color)]);
+      non_pawn_table_score.store(
+          UpdateTableScore(non_pawn_table_score.load(std::memory_order_relaxed),
+                           weight,
+                           scaled_bonus),
+          std::memory_order_relaxed);
+    }
+  }
+
+  // Brings this position's table slots into cache ahead of CorrectStaticEval,
+  // so that the loads overlap with the TT probe and evaluation
+  void Prefetch(const BoardState &state) const {
+    __builtin_prefetch(&pawn_table_[state.turn][GetPawnTableIndex(state)]);
+    for (Color color : {Color::kWhite, Color::kBlack}) {
+      __builtin_prefetch(&non_pawn_table_[state.turn][color]
+                                         [GetNonPawnTableIndex(state, color)]);
     }
   }
 
   [[nodiscard]] Score CorrectStaticEval(const BoardState &state,
                                         Score static_eval) const {
-    const Score pawn_correction =
-        pawn_table_[state.turn][GetPawnTableIndex(state)];
-    const Score non_pawn_white_correction =
+    const Score pawn_correction = LoadScore(
+        pawn_table_[state.turn][GetPawnTableIndex(state)]);
+    const Score non_pawn_white_correction = LoadScore(
         non_pawn_table_[state.turn][Color::kWhite]
-                       [GetNonPawnTableIndex(state, Color::kWhite)];
-    const Score non_pawn_black_correction =
+                       [GetNonPawnTableIndex(state, Color::kWhite)]);
+    const Score non_pawn_black_correction = LoadScore(
         non_pawn_table_[state.turn][Color::kBlack]
-                       [GetNonPawnTableIndex(state, Color::kBlack)];
+                       [GetNonPawnTableIndex(state, Color::kBlack)]);
     const Score correction =
         pawn_correction +
         (non_pawn_white_correction + non_pawn_black_correction) / 2;
@@ -64,6 +91,12 @@ class CorrectionHistory {
   }
 
  private:
+  [[nodiscard]] static Score LoadScore(const Score &score) {
+    // std::atomic_ref can't refer to a const object until C++26
+    return std::atomic_ref(const_cast<Score &>(score))
+        .load(std::memory_order_relaxed);
+  }
+
   [[nodiscard]] int CalculateWeight(int depth) {
     return std::min(1 + depth, 16);
   }
@@ -17,14 +17,47 @@ class History {
 
   void Initialize() {
     quiet_history = std::make_unique<QuietHistory>();
-    continuation_history = std::make_unique<ContinuationHistory>();
-    correction_history = std::make_unique<CorrectionHistory>();
     capture_history = std::make_unique<CaptureHistory>();
+    if (!shares_continuation_history_) {
+      continuation_history = std::make_shared<ContinuationHistory>();
+    }
+    if (!shares_correction_history_) {
+      correction_history = std::make_shared<CorrectionHistory>();
+    }
   }
 
-  // Reinitialize the history objects for quicker clearing
+  // Clears the tables in place instead of reallocating them, leaving shared
+  // tables for their owner to clear
   void Clear() {
-    Initialize();
+    quiet_history->Clear();
+    capture_history->Clear();
+    if (!shares_continuation_history_) {
+      continuation_history->Clear();
+    }
+    if (!shares_correction_history_) {
+      correction_history->Clear();
+    }
+  }
+
+  // Uses the given tables in place of this thread's own, or goes back to
+  // private tables when they are null
+  void SetSharedTables(std::shared_ptr<ContinuationHistory> continuation,
+                       std::shared_ptr<CorrectionHistory> correction) {
+    if (continuation) {
+      continuation_history = std::move(continuation);
+      shares_continuation_history_ = true;
+    } else if (shares_continuation_history_) {
+      continuation_history = std::make_shared<ContinuationHistory>();
+      shares_continuation_history_ = false;
+    }
+
+    if (correction) {
+      correction_history = std::move(correction);
+      shares_correction_history_ = true;
+    } else if (shares_correction_history_) {
+      correction_history = std::make_shared<CorrectionHistory>();
+      shares_correction_history_ = false;
+    }
   }
 
   [[nodiscard]] int GetQuietMoveScore(const BoardState &state,
@@ -45,8 +78,12 @@ class History {
  public:
   std::unique_ptr<QuietHistory> quiet_history;
   std::unique_ptr<CaptureHistory> capture_history;
-  std::unique_ptr<ContinuationHistory> continuation_history;
-  std::unique_ptr<CorrectionHistory> correction_history;
+  std::shared_ptr<ContinuationHistory> continuation_history;
+  std::shared_ptr<CorrectionHistory> correction_history;
+
+ private:
+  bool shares_continuation_history_ = false;
+  bool shares_correction_history_ = false;
 };
 
 }  // namespace search::history
@@ -0,0 +1,33 @@
+#ifndef INTEGRAL_HISTORY_SCORE_H
+#define INTEGRAL_HISTORY_SCORE_H
+
+#include <atomic>
+
+#include "../../../utils/multi_array.h"
+#include "../../../utils/types.h"
+
+namespace search::history {
+
+// History scores never grow past the gravity of their updates, so 16 bits are
+// enough and halve the cache footprint of the tables
+using HistoryScore = I16;
+
+// Scores of every [turn][piece][to] move following a certain move, laid out
+// so that the moves of a piece are scored from the same cache lines
+using ContinuationEntry =
+    MultiArray<HistoryScore, kNumColors, kNumPieceTypes, kSquareCount>;
+
+// The [piece][to] scores of a continuation entry for one side to move
+using ContinuationScores =
+    MultiArray<HistoryScore, kNumPieceTypes, kSquareCount>;
+
+// Reads a score from a table that other threads may be updating
+inline HistoryScore LoadHistoryScore(const HistoryScore &score) {
+  // std::atomic_ref can't refer to a const object until C++26
+  return std::atomic_ref(const_cast<HistoryScore &>(score))
+      .load(std::memory_order_relaxed);
+}
+
+}  // namespace search::history
+
+#endif  // INTEGRAL_HISTORY_SCORE_H
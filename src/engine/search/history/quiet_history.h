@@ -11,11 +11,15 @@ class QuietHistory {
  public:
   QuietHistory() : table_({}) {}
 
+  void Clear() {
+    ClearMultiArray(table_);
+  }
+
   void UpdateMoveScore(Color turn, Move move, BitBoard threats, int bonus) {
     // Apply a linear dampening to the bonus as the depth increases
-    int &score =
+    auto &score =
         table_[turn][move.GetFrom()][move.GetTo()][ThreatIndex(move, threats)];
-    score += ScaleBonus(score, bonus);
+    score = ApplyBonus(score, bonus);
   }
 
   void UpdateScore(const BoardState &state,
@@ -47,7 +51,7 @@ class QuietHistory {
   }
 
  private:
-  MultiArray<int, kNumColors, kSquareCount, kSquareCount, 4> table_;
+  MultiArray<HistoryScore, kNumColors, kSquareCount, kSquareCount, 4> table_;
 };
 
 }  // namespace search::history
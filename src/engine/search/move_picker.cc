@@ -1,5 +1,7 @@
 #include "move_picker.h"
 
+#include "../../utils/timers.h"
+
 namespace search {
 
 MovePicker::MovePicker(MovePickerType type,
@@ -15,15 +17,19 @@ MovePicker::MovePicker(MovePickerType type,
       stack_(stack),
       stage_(Stage::kTTMove),
       moves_idx_(0),
-      see_threshold_(see_threshold) {}
+      see_threshold_(see_threshold),
+      quiet_sort_threshold_(kSortAllQuiets) {}
 
 Move MovePicker::Next() {
+  SCOPED_TIMER(kMovePickerNext);
+
   const auto &state = board_.GetState();
 
   if (stage_ == Stage::kTTMove) {
     stage_ = Stage::kGenerateNoisys;
 
-    if (tt_move_ && board_.IsMovePseudoLegal(tt_move_)) {
+    if (tt_move_ && board_.IsMovePseudoLegal(tt_move_) &&
+        board_.IsMoveLegal(tt_move_)) {
       if (type_ != MovePickerType::kQuiescence || state.InCheck() ||
           tt_move_.IsNoisy(state)) {
         return tt_move_;
@@ -65,7 +71,8 @@ Move MovePicker::Next() {
     if (stack_) {
       const auto first_killer = stack_->killer_moves[0];
       if (first_killer && first_killer != tt_move_ &&
-          board_.IsMovePseudoLegal(first_killer)) {
+          board_.IsMovePseudoLegal(first_killer) &&
+          board_.IsMoveLegal(first_killer)) {
         return first_killer;
       }
     }
@@ -77,7 +84,8 @@ Move MovePicker::Next() {
     if (stack_) {
       const auto second_killer = stack_->killer_moves[1];
       if (second_killer && second_killer != tt_move_ &&
-          board_.IsMovePseudoLegal(second_killer)) {
+          board_.IsMovePseudoLegal(second_killer) &&
+          board_.IsMoveLegal(second_killer)) {
         return second_killer;
       }
     }
@@ -91,7 +99,7 @@ Move MovePicker::Next() {
 
   if (stage_ == Stage::kQuiets) {
     if (moves_idx_ < quiets_.Size()) {
-      return SelectionSort(quiets_, moves_idx_++);
+      return quiets_[moves_idx_++].move;
     }
 
     stage_ = Stage::kBadNoisys;
@@ -137,13 +145,22 @@ Move &MovePicker::SelectionSort(List<ScoredMove, kMaxMoves> &move_list,
 template <MoveGenType move_type>
 void MovePicker::GenerateAndScoreMoves(List<ScoredMove, kMaxMoves> &list) {
   const auto &killers = stack_->killer_moves;
-  auto moves = move_gen::GenerateMoves(move_type, board_);
+  auto moves = move_gen::GenerateLegalMoves(move_type, board_);
   for (int i = 0; i < moves.Size(); i++) {
     auto move = moves[i];
     if (move != tt_move_ && killers[0] != move && killers[1] != move) {
-      list.Push({move, ScoreMove(move)});
+      if constexpr (move_type == MoveGenType::kQuiet) {
+        list.Push({move, 0});
+      } else {
+        list.Push({move, ScoreMove(move)});
+      }
     }
   }
+
+  if constexpr (move_type == MoveGenType::kQuiet) {
+    ScoreQuiets(list);
+    PartialInsertionSort(list, quiet_sort_threshold_);
+  }
 }
 
 int MovePicker::ScoreMove(Move &move) {
@@ -176,7 +193,49 @@ int MovePicker::ScoreMove(Move &move) {
   // Order moves that caused a beta cutoff by their own history score
   // The higher the depth this move caused a cutoff the more likely it move will
   // be ordered first
-  return history_.GetQuietMoveScore(state, move, state.threats, stack_);
+  return history_.GetQuietMoveScore(state, move, board_.GetThreats(), stack_);
+}
+
+void MovePicker::PartialInsertionSort(List<ScoredMove, kMaxMoves> &list,
+                                      int threshold) {
+  for (int i = 1, sorted_end = 0; i < list.Size(); i++) {
+    if (list[i].score < threshold) continue;
+
+    // Grow the sorted front of the list by one, then shift the move down to
+    // its place in it
+    const ScoredMove scored_move = list[i];
+    list[i] = list[++sorted_end];
+
+    int j = sorted_end;
+    for (; j > 0 && list[j - 1].score < scored_move.score; j--) {
+      list[j] = list[j - 1];
+    }
+    list[j] = scored_move;
+  }
+}
+
+void MovePicker::ScoreQuiets(List<ScoredMove, kMaxMoves> &list) {
+  using history::ContinuationHistory;
+
+  const auto &state = board_.GetState();
+  const BitBoard threats = board_.GetThreats();
+  const auto &quiet_history = *history_.quiet_history;
+
+  // Same as History::GetQuietMoveScore, following the moves 1, 2 and 4 ply ago
+  const auto &one_ply = ContinuationHistory::GetScores(state.turn, stack_ - 1);
+  const auto &two_ply = ContinuationHistory::GetScores(state.turn, stack_ - 2);
+  const auto &four_ply = ContinuationHistory::GetScores(state.turn, stack_ - 4);
+
+  for (int i = 0; i < list.Size(); i++) {
+    const Move move = list[i].move;
+    const int piece = state.GetPieceType(move.GetFrom());
+    const int to = move.GetTo();
+
+    list[i].score = quiet_history.GetScore(state, move, threats) +
+                    history::LoadHistoryScore(one_ply[piece][to]) +
+                    history::LoadHistoryScore(two_ply[piece][to]) +
+                    history::LoadHistoryScore(four_ply[piece][to]);
+  }
 }
 
 }  // namespace search
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define INTEGRAL_MOVE_PICKER_H_
 
 #include <algorithm>
+#include <limits>
 
 #include "../../chess/move_gen.h"
 #include "../evaluation/evaluation.h"
@@ -22,6 +23,8 @@ enum class MovePickerType {
 
 class MovePicker {
  public:
+  static constexpr int kSortAllQuiets = std::numeric_limits<int>::min();
+
   enum class Stage {
     kTTMove,
     kGenerateNoisys,
@@ -40,10 +43,19 @@ class MovePicker {
              StackEntry *stack,
              int see_threshold = 0);
 
+  // Returns the next legal move, or a null move when there are none left
   Move Next();
 
   void SkipQuiets();
 
+  // Only the quiets scoring at least the threshold get sorted, the rest are
+  // left in generation order. This must only be raised once the search is
+  // certain to prune every quiet below it, and only affects quiets that have
+  // not been generated yet
+  void SetQuietSortThreshold(int threshold) {
+    quiet_sort_threshold_ = threshold;
+  }
+
   [[nodiscard]] Stage GetStage() const {
     return stage_;
   }
@@ -56,6 +68,14 @@ class MovePicker {
 
   int ScoreMove(Move &move);
 
+  // Scores all the quiets at once, looking up what only depends on the
+  // position a single time
+  void ScoreQuiets(List<ScoredMove, kMaxMoves> &list);
+
+  // Sorts the moves scoring at least the threshold to the front of the list,
+  // leaving the rest in the order they were generated
+  void PartialInsertionSort(List<ScoredMove, kMaxMoves> &list, int threshold);
+
  private:
   Board &board_;
   Move tt_move_;
@@ -67,6 +87,7 @@ class MovePicker {
   List<ScoredMove, kMaxMoves> quiets_;
   int moves_idx_;
   int see_threshold_;
+  int quiet_sort_threshold_;
 };
 
 }  // namespace search
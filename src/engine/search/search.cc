@@ -1,7 +1,9 @@
 #include "search.h"
 
+#include <ranges>
 #include <thread>
 
+#include "../../utils/timers.h"
 #include "constants.h"
 #include "fmt/format.h"
 #include "move_picker.h"
@@ -44,26 +46,24 @@ const LateMoveReductionTable kLateMoveReduction =
 
 Search::Search(Board &board)
     : board_(board),
-      stop_barrier_(2),
-      start_barrier_(2),
-      search_end_barrier_(1),
-      next_thread_id_(0),
-      searching_threads_(0) {}
+      stop_(false),
+      iterations_done_(false),
+      search_epoch_(0),
+      searching_threads_(0),
+      print_info_(true) {}
 
 Search::~Search() {
-  if (!quit_.load(std::memory_order_acquire)) {
-    QuitThreads();
-  }
+  QuitThreads();
 }
 
 template <SearchType type>
 void Search::IterativeDeepening(Thread &thread) {
-  constexpr bool print_info = type == SearchType::kRegular;
+  const bool print_info = type == SearchType::kRegular && print_info_;
 
   const auto root_stack = &thread.stack.Front();
   root_stack->best_move = Move::NullMove();
 
-  Move best_move = Move::NullMove();
+  Move best_move = Move::NullMove(), ponder_move = Move::NullMove();
   Score score = 0;
 
   for (int depth = 1; depth <= time_mgmt_.GetSearchDepth(); depth++) {
@@ -87,6 +87,10 @@ void Search::IterativeDeepening(Thread &thread) {
       if (root_stack->best_move) {
         best_move = root_stack->best_move;
         score = new_score;
+
+        // The second move of the PV is the reply we expect to ponder on
+        ponder_move = root_stack->pv.Length() > 1 ? root_stack->pv[1]
+                                                  : Move::NullMove();
       }
 
       if (score <= alpha) {
@@ -118,9 +122,14 @@ void Search::IterativeDeepening(Thread &thread) {
       window *= asp_window_growth;
     }
 
-    if (ShouldQuit(thread) ||
-        (thread.IsMainThread() &&
-         time_mgmt_.ShouldStop(best_move, depth, thread.nodes_searched))) {
+    if (ShouldQuit(thread)) {
+      break;
+    }
+
+    thread.completed_depth = depth;
+
+    if (thread.IsMainThread() &&
+        time_mgmt_.ShouldStop(best_move, depth, thread.nodes_searched)) {
       break;
     }
 
@@ -146,35 +155,59 @@ void Search::IterativeDeepening(Thread &thread) {
 
   const auto SendStoppedSignal = [&]() {
     if constexpr (type == SearchType::kRegular) {
-      {
-        std::unique_lock lock(thread_stopped_mutex_);
-        // Wait on the other threads to finish before reporting the best move
-        --searching_threads_;
-        thread_stopped_signal_.notify_all();
+      // Only the main thread and UCI thread ever wait on the count, and only
+      // for it to reach one or zero
+      if (searching_threads_.fetch_sub(1, std::memory_order_acq_rel) <= 2) {
+        searching_threads_.notify_all();
       }
-      search_end_barrier_.ArriveAndWait();
     }
   };
 
   if (thread.IsMainThread()) {
-    // Don't report the best move until manually stopped with go infinite
-    if (time_mgmt_.IsInfinite()) {
-      while (!stop_.load(std::memory_order_relaxed)) std::this_thread::yield();
+    if constexpr (type == SearchType::kRegular) {
+      iterations_done_.store(true, std::memory_order_seq_cst);
+
+      // Don't report the best move until manually stopped with go infinite,
+      // or until the opponent has replied while pondering
+      if (time_mgmt_.IsInfinite() || time_mgmt_.IsPondering()) {
+        stop_.wait(false, std::memory_order_acquire);
+      }
     }
 
-    std::unique_lock lock(stop_mutex_);
     stop_.store(true, std::memory_order_seq_cst);
-    SendStoppedSignal();
+
+    // Wait on the other threads to finish before reporting the best move
+    if constexpr (type == SearchType::kRegular) {
+      int running;
+      while ((running = searching_threads_.load(std::memory_order_acquire)) >
+             1) {
+        searching_threads_.wait(running, std::memory_order_acquire);
+      }
+    }
+
+    if (print_info && best_move && !ponder_move) {
+      ponder_move = ProbePonderMove(thread.board, best_move);
+    }
 
     // Age the transposition table to recognize TT entries from past searches
     transposition_table_.Age();
 
     if (print_info) {
-      fmt::println("bestmove {}", best_move.ToString());
+      if (ponder_move) {
+        fmt::println("bestmove {} ponder {}",
+                     best_move.ToString(),
+                     ponder_move.ToString());
+      } else {
+        fmt::println("bestmove {}", best_move.ToString());
+      }
+
+      if constexpr (type == SearchType::kRegular) {
+        timers::Print();
+      }
     }
-  } else {
-    SendStoppedSignal();
   }
+
+  SendStoppedSignal();
 }
 
 template <NodeType node_type>
@@ -204,6 +237,12 @@ Score Search::QuiescentSearch(Thread &thread,
   // is one which has most of its child moves searched
   constexpr bool in_pv_node = node_type != NodeType::kNonPV;
 
+  // Start fetching the correction history slots, which are only needed once
+  // the TT has been probed and the position evaluated
+  if (!stack->in_check) {
+    history.correction_history->Prefetch(state);
+  }
+
   // Probe the transposition table to see if we have already evaluated this
   // position
   const int tt_depth = state.InCheck();
@@ -275,10 +314,6 @@ Score Search::QuiescentSearch(Thread &thread,
       break;
     }
 
-    if (!board.IsMoveLegal(move)) {
-      continue;
-    }
-
     // QS Futility Pruning: Prune capture moves that don't win material if the
     // static eval is behind alpha by some margin
     if (!stack->in_check && move.IsCapture(state) && futility_score <= alpha &&
@@ -401,6 +436,11 @@ Score Search::PVSearch(Thread &thread,
     }
   }
 
+  // Overlap the correction history loads with the TT probe and evaluation
+  if (!stack->in_check) {
+    history.correction_history->Prefetch(state);
+  }
+
   // Probe the transposition table to see if we have already evaluated this
   // position
   TranspositionTableEntry *tt_entry = nullptr;
@@ -629,7 +669,7 @@ Score Search::PVSearch(Thread &thread,
             break;
           }
 
-          if (move == stack->excluded_tt_move || !board.IsMoveLegal(move)) {
+          if (move == stack->excluded_tt_move) {
             continue;
           }
 
@@ -691,7 +731,7 @@ Score Search::PVSearch(Thread &thread,
   // Keep track of quiet and capture moves that failed to cause a beta cutoff
   MoveList quiets, captures;
 
-  stack->threats = state.threats;
+  stack->threats = board.GetThreats();
 
   int moves_seen = 0;
   Score best_score = kScoreNone;
@@ -700,7 +740,7 @@ Score Search::PVSearch(Thread &thread,
   MovePicker move_picker(
       MovePickerType::kSearch, board, tt_move, history, stack);
   while (const auto move = move_picker.Next()) {
-    if (move == stack->excluded_tt_move || !board.IsMoveLegal(move)) {
+    if (move == stack->excluded_tt_move) {
       continue;
     }
 
@@ -900,6 +940,15 @@ Score Search::PVSearch(Thread &thread,
     if (score > best_score) {
       best_score = score;
 
+      // From here on the pruning guards apply to every move, so the first quiet
+      // at or below the history pruning margin is pruned and the picker skips
+      // the rest, which means they don't need to be sorted
+      if (!in_root && depth <= hist_prune_depth &&
+          best_score > -kTBWinInMaxPlyScore) {
+        move_picker.SetQuietSortThreshold(
+            hist_thresh_base + hist_thresh_mult * depth + 1);
+      }
+
       if (score > alpha) {
         stack->best_move = best_move = move;
 
@@ -979,44 +1028,117 @@ Score Search::PVSearch(Thread &thread,
   return stack->score = best_score;
 }
 
-void Search::Run(Thread &thread) {
+void Search::Run(Thread &thread, U32 epoch) {
   while (true) {
-    // Indicate that we have stopped searching
-    stop_barrier_.ArriveAndWait();
-    // Indicate that we are waiting for the search signal
-    start_barrier_.ArriveAndWait();
+    // Sleep until a new search or quit is published, which is never missed
+    // since we compare against the last epoch this thread has seen
+    search_epoch_.wait(epoch, std::memory_order_acquire);
+    epoch = search_epoch_.load(std::memory_order_acquire);
 
-    if (quit_.load(std::memory_order_acquire)) {
+    if (thread.quit) {
       return;
     }
 
+    // Woken up to let other threads quit, since the count can't drop to zero
+    // during a search without this thread finishing it
+    if (searching_threads_.load(std::memory_order_acquire) == 0) {
+      continue;
+    }
+
     IterativeDeepening<SearchType::kRegular>(thread);
   }
 }
 
 void Search::WaitForThreads() {
-  if (searching_threads_.load() > 0) {
-    std::unique_lock lock(thread_stopped_mutex_);
-    thread_stopped_signal_.wait(lock, [this] {
-      return searching_threads_.load(std::memory_order_seq_cst) == 0;
-    });
+  int running;
+  while ((running = searching_threads_.load(std::memory_order_acquire)) > 0) {
+    searching_threads_.wait(running, std::memory_order_acquire);
+  }
+}
+
+void Search::SetPrintInfo(bool print_info) {
+  print_info_ = print_info;
+}
+
+Move Search::ProbePonderMove(Board &board, Move best_move) {
+  board.MakeMove(best_move);
+
+  const auto &state = board.GetState();
+  const auto tt_entry = transposition_table_.Probe(state.zobrist_key);
+
+  Move ponder_move = Move::NullMove();
+  if (tt_entry->CompareKey(state.zobrist_key) && tt_entry->move &&
+      board.IsMovePseudoLegal(tt_entry->move) &&
+      board.IsMoveLegal(tt_entry->move)) {
+    ponder_move = tt_entry->move;
+  }
+
+  board.UndoMove();
+  return ponder_move;
+}
+
+void Search::ShareContinuationHistory(bool share) {
+  // The tables can't be swapped out from under a running search
+  Stop();
+
+  if (!share) {
+    shared_continuation_history_.reset();
+  } else if (!shared_continuation_history_) {
+    shared_continuation_history_ =
+        std::make_shared<history::ContinuationHistory>();
+  }
+
+  for (auto &thread : threads_) {
+    ShareHistoryTables(*thread);
   }
 }
 
+void Search::ShareCorrectionHistory(bool share) {
+  // The tables can't be swapped out from under a running search
+  Stop();
+
+  if (!share) {
+    shared_correction_history_.reset();
+  } else if (!shared_correction_history_) {
+    shared_correction_history_ = std::make_shared<history::CorrectionHistory>();
+  }
+
+  for (auto &thread : threads_) {
+    ShareHistoryTables(*thread);
+  }
+}
+
+void Search::ShareHistoryTables(Thread &thread) {
+  thread.history.SetSharedTables(shared_continuation_history_,
+                                 shared_correction_history_);
+}
+
 void Search::QuitThreads() {
-  if (threads_.empty()) {
+  RemoveThreads(0);
+}
+
+void Search::RemoveThreads(U16 count) {
+  if (threads_.size() <= count) {
     return;
   }
 
-  quit_.store(true, std::memory_order_release);
-  stop_barrier_.ArriveAndWait();
-  start_barrier_.ArriveAndWait();
+  Stop();
 
-  for (auto &thread : threads_) {
+  const auto removed = threads_ | std::views::drop(count);
+  for (auto &thread : removed) {
+    thread->quit = true;
+  }
+
+  search_epoch_.fetch_add(1, std::memory_order_release);
+  search_epoch_.notify_all();
+
+  for (auto &thread : removed) {
     if (thread->raw_thread.joinable()) {
       thread->raw_thread.join();
     }
   }
+
+  threads_.resize(count);
 }
 
 bool Search::ShouldQuit(Thread &thread) {
@@ -1029,42 +1151,47 @@ bool Search::ShouldQuit(Thread &thread) {
 }
 
 void Search::SetThreadCount(U16 count) {
-  if (threads_.size() == count) {
+  // Only the difference is allocated or freed, so the remaining threads keep
+  // their history tables between games
+  if (count == threads_.size()) {
+    return;
+  } else if (count < threads_.size()) {
+    RemoveThreads(count);
     return;
-  } else if (!threads_.empty()) {
-    QuitThreads();
   }
 
-  quit_.store(false, std::memory_order_release);
+  // The new threads can't be handed any search that is already running
+  Stop();
 
-  search_end_barrier_.Reset(count);
-  // Count + 1 so that we can arrive/wait in the UCI thread as well
-  stop_barrier_.Reset(count + 1);
-  start_barrier_.Reset(count + 1);
+  const U32 epoch = search_epoch_.load(std::memory_order_acquire);
 
-  threads_.clear();
-  threads_.shrink_to_fit();
   threads_.reserve(count);
-
-  next_thread_id_ = 0;
-  for (U16 i = 0; i < count; i++) {
-    auto &thread =
-        threads_.emplace_back(std::make_unique<Thread>(next_thread_id_++));
-    thread->raw_thread = std::thread([this, &thread]() { Run(*thread); });
+  for (U16 id = threads_.size(); id < count; id++) {
+    auto thread = threads_.emplace_back(std::make_unique<Thread>(id)).get();
+    ShareHistoryTables(*thread);
+    thread->raw_thread =
+        std::thread([this, thread, epoch]() { Run(*thread, epoch); });
   }
 }
 
 void Search::Start(TimeConfig time_config) {
-  if (searching_threads_.load() > 0) {
+  // The previous search may have already reported its best move while its
+  // threads are still winding down
+  if (stop_.load(std::memory_order_acquire)) {
+    WaitForThreads();
+  }
+
+  // A search is still running, which must be stopped first
+  if (searching_threads_.load(std::memory_order_acquire) > 0) {
     return;
   }
 
-  // Wait untl all search threads have stopped
-  stop_barrier_.ArriveAndWait();
   stop_.store(false, std::memory_order_relaxed);
+  iterations_done_.store(false, std::memory_order_seq_cst);
 
   time_mgmt_.SetConfig(time_config);
   time_mgmt_.Start();
+  timers::Reset();
 
   searching_threads_.store(static_cast<U16>(threads_.size()),
                            std::memory_order_seq_cst);
@@ -1073,8 +1200,9 @@ void Search::Start(TimeConfig time_config) {
     thread->SetBoard(board_);
   }
 
-  // Wait until all search threads have received the signal
-  start_barrier_.ArriveAndWait();
+  // Wake up all the workers at once
+  search_epoch_.fetch_add(1, std::memory_order_release);
+  search_epoch_.notify_all();
 }
 
 std::pair<Score, Move> Search::DataGenStart(std::unique_ptr<Thread> &thread,
@@ -1091,11 +1219,12 @@ std::pair<Score, Move> Search::DataGenStart(std::unique_ptr<Thread> &thread,
   IterativeDeepening<SearchType::kBench>(*thread);
 
   const auto &stack = thread->stack.Front();
-  return {stack.score * (board_.GetState().turn == Color::kBlack ? -1 : 1),
-          stack.best_move};
+  return {
+      stack.score * (thread->board.GetState().turn == Color::kBlack ? -1 : 1),
+      stack.best_move};
 }
 
-U64 Search::Bench(int depth) {
+BenchResult Search::Bench(int depth) {
   TimeConfig config{.depth = depth};
   time_mgmt_.SetConfig(config);
   time_mgmt_.Start();
@@ -1107,11 +1236,28 @@ U64 Search::Bench(int depth) {
   thread->SetBoard(board_);
 
   IterativeDeepening<SearchType::kBench>(*thread);
-  return thread->nodes_searched;
+  // The table was aged once the search finished
+  return {thread->nodes_searched,
+          thread->completed_depth,
+          thread->stack.Front().best_move,
+          transposition_table_.HashFull(1)};
+}
+
+void Search::PonderHit() {
+  time_mgmt_.PonderHit();
+
+  // The iterations may have already finished while pondering, in which case
+  // the best move can be reported right away
+  if (!time_mgmt_.IsInfinite() &&
+      iterations_done_.load(std::memory_order_seq_cst)) {
+    stop_.store(true, std::memory_order_seq_cst);
+    stop_.notify_all();
+  }
 }
 
 void Search::Stop() {
   stop_.store(true, std::memory_order_relaxed);
+  stop_.notify_all();
   WaitForThreads();
 }
 
@@ -1121,6 +1267,13 @@ void Search::NewGame(bool clear_tables) {
     eval::pawn_cache.Clear();
   }
 
+  if (shared_continuation_history_) {
+    shared_continuation_history_->Clear();
+  }
+  if (shared_correction_history_) {
+    shared_correction_history_->Clear();
+  }
+
   for (auto &thread : threads_) {
     thread->NewGame();
   }
@@ -1137,8 +1290,16 @@ U64 Search::GetNodesSearched() const {
       });
 }
 
+int Search::GetCompletedDepth() const {
+  return threads_.front()->completed_depth;
+}
+
 void Search::ResizeHash(U64 size) {
   transposition_table_.Resize(size);
 }
 
+void Search::ClearHash() {
+  transposition_table_.Clear();
+}
+
 }  // namespace search
\ No newline at end of file
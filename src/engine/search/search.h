@@ -4,7 +4,6 @@
 #include <thread>
 
 #include "../../chess/move_gen.h"
-#include "../../utils/barrier.h"
 #include "../evaluation/evaluation.h"
 #include "history/history.h"
 #include "stack.h"
@@ -24,9 +23,22 @@ enum class SearchType {
   kBench
 };
 
+struct BenchResult {
+  U64 nodes;
+  int depth;
+  Move best_move;
+  int hash_full;
+};
+
 struct Thread {
   explicit Thread(U32 id)
-      : id(id), stack({}), nodes_searched(0), sel_depth(0), tb_hits(0) {
+      : id(id),
+        stack({}),
+        nodes_searched(0),
+        sel_depth(0),
+        completed_depth(0),
+        tb_hits(0),
+        quit(false) {
     NewGame();
   }
 
@@ -40,7 +52,7 @@ struct Thread {
   }
 
   void SetBoard(Board &new_board) {
-    board = new_board;
+    board.CopyFrom(new_board);
   }
 
   void Reset() {
@@ -49,6 +61,7 @@ struct Thread {
     // Reset info data
     nodes_searched.store(0, std::memory_order_seq_cst);
     sel_depth = 0;
+    completed_depth = 0;
     tb_hits = 0;
   }
 
@@ -59,7 +72,12 @@ struct Thread {
   Stack stack;
   std::atomic<U64> nodes_searched;
   U16 root_depth, sel_depth;
+  // Deepest iteration that was searched to the end
+  U16 completed_depth;
   U64 tb_hits;
+  // Set when the thread is removed from the pool, published to the worker
+  // through the search epoch
+  bool quit;
 };
 
 class Search {
@@ -73,26 +91,55 @@ class Search {
   std::pair<Score, Move> DataGenStart(std::unique_ptr<Thread> &thread,
                                       TimeConfig time_config);
 
-  U64 Bench(int depth);
+  BenchResult Bench(int depth);
 
   void Stop();
 
+  // The opponent played the move we were pondering on, so the search
+  // continues under the time limits it was started with
+  void PonderHit();
+
   void SetThreadCount(U16 count);
 
+  // Makes all threads of the pool search with one continuation or correction
+  // history table instead of their own
+  void ShareContinuationHistory(bool share);
+
+  void ShareCorrectionHistory(bool share);
+
   void QuitThreads();
 
+  // Blocks until every thread of the search started with Start() is done
+  void WaitForThreads();
+
+  // Toggles the info and bestmove output of searches started with Start()
+  void SetPrintInfo(bool print_info);
+
   void NewGame(bool clear_tables = true);
 
   const TimeManagement &GetTimeManagement() const;
 
   [[nodiscard]] U64 GetNodesSearched() const;
 
+  // Deepest iteration the main thread completed in the last search
+  [[nodiscard]] int GetCompletedDepth() const;
+
   void ResizeHash(U64 size);
 
+  // Clears only this search's transposition table, leaving the global pawn
+  // cache alone for searches that run alongside others
+  void ClearHash();
+
  private:
-  void Run(Thread &thread);
+  void Run(Thread &thread, U32 epoch);
 
-  void WaitForThreads();
+  // Joins and frees the threads past the first count, leaving the rest idle
+  void RemoveThreads(U16 count);
+
+  // Looks up the expected reply to the best move in the transposition table
+  Move ProbePonderMove(Board &board, Move best_move);
+
+  void ShareHistoryTables(Thread &thread);
 
   template <SearchType type>
   void IterativeDeepening(Thread &thread);
@@ -116,12 +163,18 @@ class Search {
  private:
   Board &board_;
   TimeManagement time_mgmt_;
-  std::atomic_bool stop_, quit_;
-  Barrier stop_barrier_, start_barrier_, search_end_barrier_;
-  std::mutex stop_mutex_, thread_stopped_mutex_;
-  std::atomic_int searching_threads_, next_thread_id_;
-  std::condition_variable thread_stopped_signal_;
+  std::atomic_bool stop_;
+  // Set once the main thread has finished its iterations, after which a
+  // ponder search only waits to be allowed to report its best move
+  std::atomic_bool iterations_done_;
+  // Bumped by Start() and RemoveThreads() to wake up the idle workers, which
+  // sleep on it with std::atomic::wait instead of a mutex and condition
+  std::atomic<U32> search_epoch_;
+  std::atomic_int searching_threads_;
   std::vector<std::unique_ptr<Thread>> threads_;
+  std::shared_ptr<history::ContinuationHistory> shared_continuation_history_;
+  std::shared_ptr<history::CorrectionHistory> shared_correction_history_;
+  bool print_info_;
   TranspositionTable transposition_table_;
 };
 
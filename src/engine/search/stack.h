@@ -3,6 +3,7 @@
 
 #include "../../chess/move_gen.h"
 #include "../../utils/types.h"
+#include "history/history_score.h"
 
 namespace search {
 
@@ -67,7 +68,7 @@ struct StackEntry {
   // The excluded TT move when performing singular extensions
   Move excluded_tt_move;
   // Continuation history entry for this move
-  void *continuation_entry;
+  history::ContinuationEntry *continuation_entry;
   // Moves that caused a beta cutoff at this ply
   std::array<Move, 2> killer_moves;
   // Overall improving rate from the last couple plies
@@ -35,7 +35,7 @@ bool TimeConfig::operator==(const TimeConfig& other) const {
   return infinite == other.infinite && depth == other.depth &&
          move_time == other.move_time && time_left == other.time_left &&
          increment == other.increment && nodes == other.nodes &&
-         soft_nodes == other.soft_nodes;
+         soft_nodes == other.soft_nodes && ponder == other.ponder;
 }
 
 // DepthLimiter implementation
@@ -89,6 +89,8 @@ TimedLimiter::TimedLimiter(int time_left, int increment, int move_time)
     : time_left_(time_left),
       increment_(increment),
       move_time_(move_time),
+      start_time_(0),
+      end_time_(0),
       previous_best_move_(Move::NullMove()),
       best_move_stability_(0) {
   CalculateLimits();
@@ -135,7 +137,7 @@ bool TimedLimiter::TimesUp(U32 nodes_searched) {
 }
 
 void TimedLimiter::Start() {
-  start_time_ = GetCurrentTime();
+  start_time_.store(GetCurrentTime(), std::memory_order_relaxed);
   nodes_spent_.fill(0);
 }
 
@@ -143,15 +145,21 @@ void TimedLimiter::Stop() {
   end_time_ = GetCurrentTime();
 }
 
+void TimedLimiter::RestartClock() {
+  start_time_.store(GetCurrentTime(), std::memory_order_relaxed);
+}
+
 U64 TimedLimiter::TimeElapsed() const {
-  return std::max<U64>(1, GetCurrentTime() - start_time_);
+  return std::max<U64>(
+      1, GetCurrentTime() - start_time_.load(std::memory_order_relaxed));
 }
 
 void TimedLimiter::CalculateLimits() {
   const int overhead = uci::listener.GetOption("MoveOverhead").GetValue<int>();
 
   if (move_time_ != 0) {
-    hard_limit_ = move_time_ - overhead;
+    // Very short move times would otherwise underflow and never stop
+    hard_limit_ = std::max(1, move_time_ - overhead);
     soft_limit_ = hard_limit_;
     return;
   }
@@ -187,9 +195,19 @@ TimeManagement::TimeManagement(const TimeConfig& config) {
 
 void TimeManagement::SetConfig(const TimeConfig& config) {
   config_ = config;
+  pondering_.store(config.ponder, std::memory_order_seq_cst);
   ConfigureLimiters(config);
 }
 
+void TimeManagement::PonderHit() {
+  // The clock given with go ponder only starts running once the opponent has
+  // played the expected move
+  if (auto timed_limiter = GetTimedLimiter()) {
+    timed_limiter->RestartClock();
+  }
+  pondering_.store(false, std::memory_order_seq_cst);
+}
+
 void TimeManagement::ConfigureLimiters(const TimeConfig& config) {
   limiters_.clear();
 
@@ -238,6 +256,10 @@ bool TimeManagement::IsInfinite() const {
   return config_.infinite;
 }
 
+bool TimeManagement::IsPondering() const {
+  return pondering_.load(std::memory_order_seq_cst);
+}
+
 void TimeManagement::Start() {
   start_time_ = GetCurrentTime();
   for (const auto& limiter : limiters_) {
@@ -253,6 +275,10 @@ void TimeManagement::Stop() {
 }
 
 bool TimeManagement::ShouldStop(Move best_move, int depth, U32 nodes_searched) {
+  if (pondering_.load(std::memory_order_acquire)) {
+    return false;
+  }
+
   for (const auto& limiter : limiters_) {
     if (limiter->ShouldStop(best_move, depth, nodes_searched)) {
       return true;
@@ -262,6 +288,10 @@ bool TimeManagement::ShouldStop(Move best_move, int depth, U32 nodes_searched) {
 }
 
 bool TimeManagement::TimesUp(U32 nodes_searched) {
+  if (pondering_.load(std::memory_order_acquire)) {
+    return false;
+  }
+
   for (const auto& limiter : limiters_) {
     if (limiter->TimesUp(nodes_searched)) {
       return true;
@@ -2,6 +2,7 @@
 #define INTEGRAL_TIME_MGMT_H_
 
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <memory>
 #include <optional>
@@ -23,6 +24,7 @@ struct TimeConfig {
   int move_time = 0;
   int time_left = 0;
   int increment = 0;
+  bool ponder = false;
 
   [[nodiscard]] bool HasBeenModified() const;
   bool operator==(const TimeConfig& other) const;
@@ -98,6 +100,9 @@ class TimedLimiter : public TimeLimiter {
 
   void Stop() override;
 
+  // Restarts the clock without discarding the effort spent on each move
+  void RestartClock();
+
   [[nodiscard]] U64& NodesSpent(Move move);
 
   [[nodiscard]] U64 TimeElapsed() const;
@@ -114,7 +119,9 @@ class TimedLimiter : public TimeLimiter {
   int move_time_;
   TimeStamp hard_limit_;
   TimeStamp soft_limit_;
-  TimeStamp start_time_, end_time_;
+  // Restarted by ponderhit on the UCI thread while the search thread reads it
+  std::atomic<TimeStamp> start_time_;
+  TimeStamp end_time_;
   Move previous_best_move_;
   int best_move_stability_;
   std::array<U64, 4096> nodes_spent_;
@@ -136,6 +143,9 @@ class TimeManagement {
 
   bool TimesUp(U32 nodes_searched);
 
+  // Switches a ponder search over to its limits, which start counting now
+  void PonderHit();
+
   TimedLimiter* GetTimedLimiter();
 
   [[nodiscard]] U64 TimeElapsed() const;
@@ -144,10 +154,14 @@ class TimeManagement {
 
   [[nodiscard]] bool IsInfinite() const;
 
+  [[nodiscard]] bool IsPondering() const;
+
  private:
   void ConfigureLimiters(const TimeConfig& config);
 
   TimeConfig config_;
+  // The limits are ignored until the opponent plays the expected move
+  std::atomic_bool pondering_ = false;
   std::vector<std::unique_ptr<TimeLimiter>> limiters_;
   TimeStamp start_time_ = 0;
   TimeStamp end_time_ = 0;
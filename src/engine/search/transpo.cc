@@ -1,11 +1,14 @@
 #include "transpo.h"
 
+#include "../../utils/timers.h"
 #include "../evaluation/evaluation.h"
 
 namespace search {
 
 [[nodiscard]] TranspositionTableEntry *TranspositionTable::Probe(
     const U64 &key) {
+  SCOPED_TIMER(kTTProbe);
+
   auto &cluster = (*this)[key];
   // Default to replacing the first entry (if it's available)
   auto replace_entry = &cluster.entries[0];
@@ -62,12 +65,14 @@ void TranspositionTable::Age() {
   age_ = (age_ + 1) % kMaxTTAge;
 }
 
-int TranspositionTable::HashFull() const {
+int TranspositionTable::HashFull(int searches_ago) const {
+  const int age = (kMaxTTAge + age_ - searches_ago) % kMaxTTAge;
+
   int count = 0;
   for (int i = 0; i < 1000; i++) {
     count +=
-        std::ranges::count_if(table_[i].entries, [this](const auto &entry) {
-          return entry.bits.age == age_ && entry.key != 0 &&
+        std::ranges::count_if(table_[i].entries, [age](const auto &entry) {
+          return entry.bits.age == age && entry.key != 0 &&
                  entry.score != kScoreNone;
         });
   }
@@ -115,7 +115,8 @@ struct TranspositionTableCluster {
   U16 padding;
 };
 
-constexpr int kMaxTTAge = 64;
+// Ages wrap around within the five bits an entry has to store them
+constexpr int kMaxTTAge = 1 << 5;
 
 class TranspositionTable : public AlignedHashTable<TranspositionTableCluster> {
  public:
@@ -133,7 +134,9 @@ class TranspositionTable : public AlignedHashTable<TranspositionTableCluster> {
 
   void Age();
 
-  [[nodiscard]] int HashFull() const;
+  // Permille of the table written to by the search the given number of
+  // searches ago
+  [[nodiscard]] int HashFull(int searches_ago = 0) const;
 
   virtual void Clear();
 
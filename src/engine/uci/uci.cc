@@ -7,6 +7,7 @@
 #include "../../ascii_logo.h"
 #include "../../chess/move_gen.h"
 #include "../../data_gen/data_gen.h"
+#include "../../data_gen/data_tool.h"
 #include "../../engine/evaluation/pawn_structure_cache.h"
 #include "../../tests/tests.h"
 #include "../search/search.h"
@@ -28,7 +29,14 @@ void Initialize(search::Search &search) {
   listener.AddOption<OptionVisibility::kPublic>("Threads", 1, 1, 256, [&search](const Option &option) {
     search.SetThreadCount(option.GetValue<U16>());
   });
+  listener.AddOption<OptionVisibility::kPublic>("ShareContinuationHistory", false, [&search](const Option &option) {
+    search.ShareContinuationHistory(option.GetValue<bool>());
+  });
+  listener.AddOption<OptionVisibility::kPublic>("ShareCorrectionHistory", false, [&search](const Option &option) {
+    search.ShareCorrectionHistory(option.GetValue<bool>());
+  });
   listener.AddOption<OptionVisibility::kPublic>("MoveOverhead", 10, 0, 10000);
+  listener.AddOption<OptionVisibility::kPublic>("Ponder", false);
   listener.AddOption<OptionVisibility::kPublic>("SyzygyPath", std::string("<empty>"), [](const Option &option) {
     syzygy::SetPath(option.GetValue<std::string>());
   });
@@ -69,7 +77,10 @@ void Initialize(Board &board, search::Search &search) {  // clang-format off
 
   listener.RegisterCommand("go", CommandType::kUnordered, {
     CreateArgument("perft", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("threads", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("hash", ArgumentType::kOptional, LimitedInputProcessor<1>()),
     CreateArgument("infinite", ArgumentType::kOptional, NoInputProcessor()),
+    CreateArgument("ponder", ArgumentType::kOptional, NoInputProcessor()),
     CreateArgument("movetime", ArgumentType::kOptional, LimitedInputProcessor<1>()),
     CreateArgument("depth", ArgumentType::kOptional, LimitedInputProcessor<1>()),
     CreateArgument("nodes", ArgumentType::kOptional, LimitedInputProcessor<1>()),
@@ -81,7 +92,16 @@ void Initialize(Board &board, search::Search &search) {  // clang-format off
   }, [&board, &search](Command *cmd) {
     const auto perft_depth = cmd->ParseArgument<int>("perft");
     if (perft_depth) {
-      tests::Perft(board, *perft_depth);
+      const auto perft_threads = cmd->ParseArgument<int>("threads");
+      const auto perft_hash = cmd->ParseArgument<int>("hash");
+      if ((perft_threads || perft_hash) && *perft_depth > 0) {
+        tests::ParallelPerft(board,
+                             *perft_depth,
+                             std::max(perft_threads.value_or(1), 1),
+                             std::max(perft_hash.value_or(0), 0));
+      } else {
+        tests::Perft(board, *perft_depth);
+      }
       return;
     }
 
@@ -121,6 +141,9 @@ void Initialize(Board &board, search::Search &search) {  // clang-format off
     if (cmd->ArgumentExists("infinite") || !time_config.HasBeenModified())
       time_config.infinite = true;
 
+    // The limits only apply once the opponent plays the expected move
+    if (cmd->ArgumentExists("ponder")) time_config.ponder = true;
+
     search.Start(time_config);
   });
 
@@ -132,6 +155,12 @@ void Initialize(Board &board, search::Search &search) {  // clang-format off
     CreateArgument("min_moves", ArgumentType::kRequired, LimitedInputProcessor<1>()),
     CreateArgument("max_moves", ArgumentType::kRequired, LimitedInputProcessor<1>()),
     CreateArgument("out", ArgumentType::kRequired, LimitedInputProcessor<1>()),
+    CreateArgument("keep_history", ArgumentType::kOptional, NoInputProcessor()),
+    CreateArgument("keep_tt", ArgumentType::kOptional, NoInputProcessor()),
+    CreateArgument("verify_nodes", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("in_flight", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("resume", ArgumentType::kOptional, NoInputProcessor()),
+    CreateArgument("compress", ArgumentType::kOptional, NoInputProcessor()),
   }, [](Command *cmd) {
     data_gen::Config config{
       .soft_node_limit = *cmd->ParseArgument<U64>("soft_limit"),
@@ -141,10 +170,65 @@ void Initialize(Board &board, search::Search &search) {  // clang-format off
       .min_move_plies = *cmd->ParseArgument<I32>("min_moves"),
       .max_move_plies = *cmd->ParseArgument<I32>("max_moves"),
       .output_file = *cmd->ParseArgument<std::string>("out"),
+      .clear_history = !cmd->ArgumentExists("keep_history"),
+      .clear_tt = !cmd->ArgumentExists("keep_tt"),
+      .verification_nodes = cmd->ParseArgument<U64>("verify_nodes").value_or(1'000'000),
+      .games_in_flight = std::max(cmd->ParseArgument<I32>("in_flight").value_or(1), 1),
+      .resume = cmd->ArgumentExists("resume"),
+      .compress = cmd->ArgumentExists("compress"),
     };
     data_gen::Generate(config);
   });
 
+  listener.RegisterCommand("datatool", CommandType::kUnordered, {
+    CreateArgument("validate", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("shuffle", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("compress", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("decompress", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("out", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("shards", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("memory", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("threads", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+  }, [](Command *cmd) {
+    const auto threads = cmd->ParseArgument<int>("threads");
+    const int num_threads = std::clamp(threads.value_or(1), 1, 256);
+
+    if (cmd->ArgumentExists("validate")) {
+      data_gen::ValidateBinPack(*cmd->ParseArgument<std::string>("validate"), num_threads);
+    } else if (cmd->ArgumentExists("shuffle")) {
+      const auto input = *cmd->ParseArgument<std::string>("shuffle");
+      data_gen::ShuffleBinPack(input,
+                               cmd->ParseArgument<std::string>("out").value_or(input + "-shuffled"),
+                               std::clamp(cmd->ParseArgument<int>("shards").value_or(1), 1, 1024),
+                               cmd->ParseArgument<U64>("memory").value_or(1024));
+    } else if (cmd->ArgumentExists("compress")) {
+      const auto input = *cmd->ParseArgument<std::string>("compress");
+      data_gen::CompressBinPack(input,
+                                cmd->ParseArgument<std::string>("out").value_or(input + "-compressed"),
+                                num_threads);
+    } else if (cmd->ArgumentExists("decompress")) {
+      const auto input = *cmd->ParseArgument<std::string>("decompress");
+      data_gen::DecompressBinPack(input,
+                                  cmd->ParseArgument<std::string>("out").value_or(input + "-decompressed"),
+                                  num_threads);
+    } else {
+      fmt::println("Error: No datatool operation given");
+    }
+  });
+
+  listener.RegisterCommand("rescore", CommandType::kUnordered, {
+    CreateArgument("in", ArgumentType::kRequired, LimitedInputProcessor<1>()),
+    CreateArgument("out", ArgumentType::kRequired, LimitedInputProcessor<1>()),
+    CreateArgument("threads", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("nodes", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+  }, [](Command *cmd) {
+    const auto threads = cmd->ParseArgument<int>("threads");
+    data_gen::RescoreBinPack(*cmd->ParseArgument<std::string>("in"),
+                             *cmd->ParseArgument<std::string>("out"),
+                             std::clamp(threads.value_or(1), 1, 256),
+                             cmd->ParseArgument<U64>("nodes").value_or(0));
+  });
+
   listener.RegisterCommand("stop", CommandType::kUnordered, {
     CreateArgument("datagen", ArgumentType::kOptional, NoInputProcessor()),
   }, [&search](Command *cmd) {
@@ -154,6 +238,10 @@ void Initialize(Board &board, search::Search &search) {  // clang-format off
     }
   });
 
+  listener.RegisterCommand("ponderhit", CommandType::kUnordered, {}, [&search](Command *cmd) {
+    search.PonderHit();
+  });
+
   listener.RegisterCommand("ucinewgame", CommandType::kUnordered, {}, [&search](Command *cmd) {
     search.NewGame();
   });
@@ -179,9 +267,17 @@ void Initialize(Board &board, search::Search &search) {  // clang-format off
   listener.RegisterCommand("test", CommandType::kUnordered, {
     CreateArgument("see", ArgumentType::kOptional, NoInputProcessor()),
     CreateArgument("perft", ArgumentType::kOptional, NoInputProcessor()),
+    CreateArgument("sliders", ArgumentType::kOptional, NoInputProcessor()),
+    CreateArgument("latency", ArgumentType::kOptional, NoInputProcessor()),
+    CreateArgument("scaling", ArgumentType::kOptional, NoInputProcessor()),
+    CreateArgument("datagen", ArgumentType::kOptional, NoInputProcessor()),
   }, [](Command *cmd) {
     if (cmd->ArgumentExists("see")) tests::SEESuite();
     else if (cmd->ArgumentExists("perft")) tests::PerftSuite();
+    else if (cmd->ArgumentExists("sliders")) tests::SliderSuite();
+    else if (cmd->ArgumentExists("latency")) tests::LatencySuite();
+    else if (cmd->ArgumentExists("scaling")) tests::ScalingSuite(tests::kDefaultScalingDepth);
+    else if (cmd->ArgumentExists("datagen")) tests::DataGenSuite();
     else {
       tests::SEESuite();
       tests::PerftSuite();
@@ -189,11 +285,41 @@ void Initialize(Board &board, search::Search &search) {  // clang-format off
   });
 
   listener.RegisterCommand("bench", CommandType::kUnordered, {
-    CreateArgument("depth", ArgumentType::kOptional, NoInputProcessor()),
+    CreateArgument("depth", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("profile", ArgumentType::kOptional, NoInputProcessor()),
+    CreateArgument("threads", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("hash", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("movetime", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("csv", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("compare", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("runs", ArgumentType::kOptional, LimitedInputProcessor<1>()),
   }, [](Command *cmd) {
     const auto bench_depth = cmd->ParseArgument<int>("depth");
-    if (bench_depth) tests::BenchSuite(*bench_depth);
-    else tests::BenchSuite(tests::kDefaultBenchDepth);
+    const int depth = bench_depth ? *bench_depth : tests::kDefaultBenchDepth;
+
+    const auto threads = cmd->ParseArgument<int>("threads");
+    const auto hash = cmd->ParseArgument<int>("hash");
+    const auto move_time = cmd->ParseArgument<int>("movetime");
+
+    // Any of the search limits runs the bench through the thread pool
+    if (threads || hash || move_time) {
+      tests::ThreadedBenchSuite(std::clamp(threads.value_or(1), 1, 256),
+                                std::max(hash.value_or(64), 1),
+                                std::max(move_time.value_or(0), 0),
+                                depth);
+    } else if (cmd->ArgumentExists("csv") || cmd->ArgumentExists("compare")) {
+      const auto runs = cmd->ParseArgument<int>("runs");
+      const int num_runs = std::max(runs.value_or(tests::kDefaultBenchRuns), 1);
+      if (cmd->ArgumentExists("csv")) {
+        tests::BenchCsvSuite(depth, num_runs, *cmd->ParseArgument<std::string>("csv"));
+      } else {
+        tests::BenchCompareSuite(depth, num_runs, *cmd->ParseArgument<std::string>("compare"));
+      }
+    } else if (cmd->ArgumentExists("profile")) {
+      tests::BenchProfileSuite(depth);
+    } else {
+      tests::BenchSuite(depth);
+    }
   });
 
   listener.RegisterCommand("uci", CommandType::kUnordered, {}, [](Command *cmd) {
@@ -1,5 +1,7 @@
 #include "attacks.h"
 
+#include <cassert>
+
 #include "precomputed.h"
 
 namespace magics::attacks {
@@ -117,53 +119,78 @@ BitBoard GenerateRookMoves(Square square, const BitBoard &occupied) {
          SlidingAttacks<Direction::kWest>(square, occupied);
 }
 
-BishopAttacksTable GenerateBishopAttacks() {
-  BishopAttacksTable bishop_attacks{};
-
+void GenerateBishopAttacks(BishopAttacksTable &table) {
   for (int square = 0; square < kSquareCount; square++) {
     // Compute the attack and blocker combinations for bishops
     auto entry = kBishopMagics[square];
     auto blockers = attacks::CreateBlockers(entry.mask);
 
-    std::array<BitBoard, kBishopBlockerCombinations> square_bishop_attacks{};
-
     for (const auto &occupied : blockers) {
       const U64 magic_index =
           ((entry.mask & occupied.AsU64()) * entry.magic) >> entry.shift;
-      square_bishop_attacks[magic_index] =
+      table[square][magic_index] =
           attacks::GenerateBishopMoves(Square(square), occupied);
     }
-
-    bishop_attacks[square] = square_bishop_attacks;
   }
-
-  return bishop_attacks;
 }
 
-RookAttacksTable GenerateRookAttacks() {
-  RookAttacksTable rook_attacks{};
-
+void GenerateRookAttacks(RookAttacksTable &table) {
   for (int square = 0; square < kSquareCount; square++) {
     // Compute the attack and blocker combinations for rooks
     auto entry = kRookMagics[square];
     auto blockers = attacks::CreateBlockers(entry.mask);
 
-    std::array<BitBoard, kRookBlockerCombinations> square_rook_attacks{};
-
     for (const auto &occupied : blockers) {
       const U64 magic_index =
           ((entry.mask & occupied.AsU64()) * entry.magic) >> entry.shift;
-      square_rook_attacks[magic_index] =
+      table[square][magic_index] =
           attacks::GenerateRookMoves(Square(square), occupied);
     }
+  }
+}
+
+#ifdef INTEGRAL_PEXT_ATTACKS
+template <typename Table>
+Table GeneratePextAttacks(PextEntries &entries,
+                          BitBoard (*generate_mask)(Square),
+                          BitBoard (*generate_moves)(Square,
+                                                     const BitBoard &)) {
+  Table table{};
+
+  U32 offset = 0;
+  for (int square = 0; square < kSquareCount; square++) {
+    const BitBoard mask = generate_mask(Square(square));
+    entries[square] = {mask.AsU64(), offset};
+
+    for (const auto &occupied : CreateBlockers(mask)) {
+      const U64 pext_index = _pext_u64(occupied.AsU64(), mask.AsU64());
+      table[offset + pext_index] = generate_moves(Square(square), occupied);
+    }
 
-    rook_attacks[square] = square_rook_attacks;
+    offset += 1U << mask.PopCount();
   }
 
-  return rook_attacks;
+  assert(offset == table.size());
+  return table;
 }
 
-BishopAttacksTable kBishopAttacks = GenerateBishopAttacks();
-RookAttacksTable kRookAttacks = GenerateRookAttacks();
+PextEntries kBishopPextEntries{};
+PextEntries kRookPextEntries{};
+BishopPextTable kBishopPextAttacks = GeneratePextAttacks<BishopPextTable>(
+    kBishopPextEntries, GenerateBishopMask, GenerateBishopMoves);
+RookPextTable kRookPextAttacks = GeneratePextAttacks<RookPextTable>(
+    kRookPextEntries, GenerateRookMask, GenerateRookMoves);
+#else
+BishopAttacksTable kBishopAttacks = [] {
+  BishopAttacksTable table{};
+  GenerateBishopAttacks(table);
+  return table;
+}();
+RookAttacksTable kRookAttacks = [] {
+  RookAttacksTable table{};
+  GenerateRookAttacks(table);
+  return table;
+}();
+#endif
 
 }  // namespace magics::attacks
\ No newline at end of file
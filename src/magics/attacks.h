@@ -1,8 +1,13 @@
 #ifndef INTEGRAL_MAGICS_ATTACKS_H_
 #define INTEGRAL_MAGICS_ATTACKS_H_
 
+#if defined(__BMI2__) && !defined(INTEGRAL_NO_PEXT)
+#include <immintrin.h>
+#endif
+
 #include "../chess/bitboard.h"
 #include "../utils/multi_array.h"
+#include "precomputed.h"
 
 namespace magics::attacks {
 
@@ -14,8 +19,67 @@ using BishopAttacksTable =
 using RookAttacksTable =
     MultiArray<BitBoard, kSquareCount, kRookBlockerCombinations>;
 
+inline BitBoard BishopMagicAttacks(Square square,
+                                   const BitBoard &occupied,
+                                   const BishopAttacksTable &table) {
+  const auto &entry = kBishopMagics[square];
+  const auto magic_index = (occupied & entry.mask) * entry.magic >> entry.shift;
+  return table[square][magic_index.AsU64()];
+}
+
+inline BitBoard RookMagicAttacks(Square square,
+                                 const BitBoard &occupied,
+                                 const RookAttacksTable &table) {
+  const auto &entry = kRookMagics[square];
+  const auto magic_index = (occupied & entry.mask) * entry.magic >> entry.shift;
+  return table[square][magic_index.AsU64()];
+}
+
+void GenerateBishopAttacks(BishopAttacksTable &table);
+
+void GenerateRookAttacks(RookAttacksTable &table);
+
+// PEXT is microcoded on AMD CPUs before Zen 3 and is slower there than the
+// magics, so native builds on those CPUs define INTEGRAL_NO_PEXT
+#if defined(__BMI2__) && !defined(INTEGRAL_NO_PEXT)
+#define INTEGRAL_PEXT_ATTACKS
+
+// The PEXT tables are packed densely, with each square only taking up
+// 2^popcount(mask) entries starting at its offset
+constexpr int kBishopPextTableSize = 5248;
+constexpr int kRookPextTableSize = 102400;
+
+struct PextEntry {
+  U64 mask;
+  U32 offset;
+};
+
+using PextEntries = std::array<PextEntry, kSquareCount>;
+using BishopPextTable = std::array<BitBoard, kBishopPextTableSize>;
+using RookPextTable = std::array<BitBoard, kRookPextTableSize>;
+
+extern PextEntries kBishopPextEntries;
+extern PextEntries kRookPextEntries;
+extern BishopPextTable kBishopPextAttacks;
+extern RookPextTable kRookPextAttacks;
+
+inline BitBoard BishopPextAttacks(Square square, const BitBoard &occupied) {
+  const auto &entry = kBishopPextEntries[square];
+  return kBishopPextAttacks[entry.offset +
+                            _pext_u64(occupied.AsU64(), entry.mask)];
+}
+
+inline BitBoard RookPextAttacks(Square square, const BitBoard &occupied) {
+  const auto &entry = kRookPextEntries[square];
+  return kRookPextAttacks[entry.offset +
+                          _pext_u64(occupied.AsU64(), entry.mask)];
+}
+#else
+// The magic tables are only kept resident when they are the lookup in use,
+// PEXT builds generate them on demand for the slider benchmark
 extern BishopAttacksTable kBishopAttacks;
 extern RookAttacksTable kRookAttacks;
+#endif
 
 BitBoard GenerateBishopMask(Square square);
 
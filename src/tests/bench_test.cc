@@ -1,6 +1,15 @@
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <optional>
+
 #include "../chess/board.h"
 #include "../chess/move_gen.h"
 #include "../engine/search/search.h"
+#include "../utils/perf_counters.h"
+#include "../utils/timers.h"
 #include "tests.h"
 
 namespace tests {
@@ -64,6 +73,7 @@ void BenchSuite(int depth) {
   Board board;
   search::Search search(board);
   search.ResizeHash(64);
+  timers::Reset();
 
   U64 nodes = 0, elapsed = 0;
   for (const auto &position : kBenchFens) {
@@ -71,13 +81,527 @@ void BenchSuite(int depth) {
     search.NewGame();
 
     auto &time_mgmt = search.GetTimeManagement();
-    nodes += search.Bench(depth);
+    nodes += search.Bench(depth).nodes;
     elapsed += time_mgmt.TimeElapsed();
   }
 
+  timers::Print();
   fmt::println("{} nodes {} nps",
                nodes,
                static_cast<U64>(nodes * 1000 / std::max<U64>(elapsed, 1)));
 }
 
-}  // namespace tests
\ No newline at end of file
+// Column width of a counter, wide enough for both its name and its value
+int ProfileColumnWidth(std::size_t counter) {
+  return std::max<int>(kPerfCounterNames[counter].size(), 9);
+}
+
+std::string FormatProfileHeader() {
+  std::string result = fmt::format("{:>8} {:>10} {:>9} {:>5}",
+                                   "position",
+                                   "nodes",
+                                   "nps",
+                                   "ipc");
+  for (std::size_t i = 0; i < kNumPerfCounters; i++) {
+    result += fmt::format(
+        " {:>{}}", kPerfCounterNames[i], ProfileColumnWidth(i));
+  }
+  return result;
+}
+
+// Formats the IPC and the per-node rate of each hardware counter, or "n/a"
+// for the ones the CPU doesn't expose
+std::string FormatProfile(std::string_view name,
+                          U64 nodes,
+                          U64 elapsed,
+                          const PerfCounters::Values &values) {
+  const auto &cycles = values[static_cast<int>(PerfCounter::kCycles)];
+  const auto &instructions =
+      values[static_cast<int>(PerfCounter::kInstructions)];
+
+  std::string result =
+      fmt::format("{:>8} {:>10} {:>9} ",
+                  name,
+                  nodes,
+                  nodes * 1000 / std::max<U64>(elapsed, 1));
+  result += cycles && instructions && *cycles > 0
+              ? fmt::format("{:>5.2f}",
+                            static_cast<double>(*instructions) / *cycles)
+              : fmt::format("{:>5}", "n/a");
+
+  for (std::size_t i = 0; i < kNumPerfCounters; i++) {
+    if (values[i]) {
+      result += fmt::format(
+          " {:>{}.2f}",
+          static_cast<double>(*values[i]) / std::max<U64>(nodes, 1),
+          ProfileColumnWidth(i));
+    } else {
+      result += fmt::format(" {:>{}}", "n/a", ProfileColumnWidth(i));
+    }
+  }
+
+  return result;
+}
+
+// Runs the bench positions with hardware counters wrapped around each search,
+// to tell which subsystem a slowdown comes from without an external profiler.
+// Counters are reported per node
+void BenchProfileSuite(int depth) {
+  PerfCounters counters;
+  if (!counters.AnyAvailable()) {
+    fmt::println(
+        "warning: hardware counters are unavailable, check "
+        "/proc/sys/kernel/perf_event_paranoid or the VM's PMU support");
+  }
+
+  Board board;
+  search::Search search(board);
+  search.ResizeHash(64);
+
+  fmt::println("{}", FormatProfileHeader());
+
+  U64 total_nodes = 0, total_elapsed = 0;
+  PerfCounters::Values totals;
+  totals.fill(0);
+
+  for (std::size_t i = 0; i < kBenchFens.size(); i++) {
+    board.SetFromFen(kBenchFens[i]);
+    search.NewGame();
+
+    counters.Start();
+    const U64 nodes = search.Bench(depth).nodes;
+    const auto values = counters.Stop();
+    const U64 elapsed = search.GetTimeManagement().TimeElapsed();
+
+    fmt::println("{}",
+                 FormatProfile(std::to_string(i + 1), nodes, elapsed, values));
+
+    total_nodes += nodes;
+    total_elapsed += elapsed;
+    for (std::size_t j = 0; j < kNumPerfCounters; j++) {
+      // A counter only has a total if it was read for every position
+      if (totals[j] && values[j]) {
+        *totals[j] += *values[j];
+      } else {
+        totals[j].reset();
+      }
+    }
+  }
+
+  fmt::println("{}",
+               FormatProfile("total", total_nodes, total_elapsed, totals));
+}
+
+struct BenchRecord {
+  int run;
+  int position;
+  std::string fen;
+  U64 nodes;
+  U64 time;
+  int depth;
+  std::string best_move;
+  int hash_full;
+
+  [[nodiscard]] double Nps() const {
+    return nodes * 1000.0 / std::max<U64>(time, 1);
+  }
+};
+
+constexpr std::string_view kBenchCsvHeader =
+    "run,position,fen,nodes,time_ms,nps,depth,best_move,hashfull";
+
+std::vector<BenchRecord> RunBenchRecords(int depth, int runs) {
+  Board board;
+  search::Search search(board);
+  search.ResizeHash(64);
+
+  std::vector<BenchRecord> records;
+  for (int run = 0; run < runs; run++) {
+    for (std::size_t i = 0; i < kBenchFens.size(); i++) {
+      board.SetFromFen(kBenchFens[i]);
+      search.NewGame();
+
+      const auto result = search.Bench(depth);
+      records.push_back({run,
+                         static_cast<int>(i),
+                         kBenchFens[i],
+                         result.nodes,
+                         search.GetTimeManagement().TimeElapsed(),
+                         result.depth,
+                         result.best_move.ToString(),
+                         result.hash_full});
+    }
+  }
+
+  return records;
+}
+
+void BenchCsvSuite(int depth, int runs, const std::string &path) {
+  std::ofstream file(path);
+  if (!file) {
+    fmt::println("Error: Failed to open bench output file {}", path);
+    return;
+  }
+
+  const auto records = RunBenchRecords(depth, runs);
+
+  file << kBenchCsvHeader << '\n';
+  for (const auto &record : records) {
+    file << fmt::format("{},{},{},{},{},{},{},{},{}\n",
+                        record.run,
+                        record.position,
+                        record.fen,
+                        record.nodes,
+                        record.time,
+                        static_cast<U64>(record.Nps()),
+                        record.depth,
+                        record.best_move,
+                        record.hash_full);
+  }
+
+  fmt::println("wrote {} runs of {} positions to {}",
+               runs,
+               kBenchFens.size(),
+               path);
+}
+
+template <typename T>
+bool ParseCsvField(std::string_view field, T &value) {
+  const auto [end, error] =
+      std::from_chars(field.data(), field.data() + field.size(), value);
+  return error == std::errc() && end == field.data() + field.size();
+}
+
+std::optional<std::vector<BenchRecord>> ReadBenchCsv(const std::string &path) {
+  std::ifstream file(path);
+  if (!file) {
+    fmt::println("Error: Failed to open bench baseline file {}", path);
+    return std::nullopt;
+  }
+
+  std::string line;
+  if (!std::getline(file, line) || line != kBenchCsvHeader) {
+    fmt::println("Error: {} is not a bench csv file", path);
+    return std::nullopt;
+  }
+
+  std::vector<BenchRecord> records;
+  for (int line_number = 2; std::getline(file, line); line_number++) {
+    if (line.empty()) continue;
+
+    // The nps column is derived from the nodes and time, so it isn't read back
+    const auto fields = SplitString(line, ',');
+    BenchRecord record;
+    if (fields.size() != 9 || !ParseCsvField(fields[0], record.run) ||
+        !ParseCsvField(fields[1], record.position) ||
+        !ParseCsvField(fields[3], record.nodes) ||
+        !ParseCsvField(fields[4], record.time) ||
+        !ParseCsvField(fields[6], record.depth) ||
+        !ParseCsvField(fields[8], record.hash_full)) {
+      fmt::println("Error: Malformed line {} in {}", line_number, path);
+      return std::nullopt;
+    }
+
+    record.fen = fields[2];
+    record.best_move = fields[7];
+    records.push_back(std::move(record));
+  }
+
+  return records;
+}
+
+struct NpsSample {
+  double mean = 0;
+  double variance = 0;
+  int count = 0;
+};
+
+NpsSample SummarizeNps(const std::vector<double> &values) {
+  NpsSample sample{.count = static_cast<int>(values.size())};
+  if (values.empty()) return sample;
+
+  sample.mean = std::accumulate(values.begin(), values.end(), 0.0) /
+                values.size();
+  if (values.size() > 1) {
+    for (const double value : values) {
+      sample.variance += (value - sample.mean) * (value - sample.mean);
+    }
+    sample.variance /= values.size() - 1;
+  }
+  return sample;
+}
+
+// Two-sided 95% critical value of Student's t distribution, rounded down to
+// the nearest tabulated degrees of freedom
+double CriticalT(double degrees_of_freedom) {
+  constexpr std::array<std::pair<double, double>, 14> kTable = {{
+      {1, 12.706}, {2, 4.303}, {3, 3.182}, {4, 2.776}, {5, 2.571},
+      {6, 2.447}, {7, 2.365}, {8, 2.306}, {9, 2.262}, {10, 2.228},
+      {15, 2.131}, {20, 2.086}, {30, 2.042}, {120, 1.980},
+  }};
+
+  double critical = kTable.front().second;
+  for (const auto &[df, value] : kTable) {
+    if (degrees_of_freedom >= df) critical = value;
+  }
+  return critical;
+}
+
+struct NpsComparison {
+  double change;
+  std::optional<double> t;
+  bool significant;
+};
+
+// Welch's t-test between the baseline and current NPS, which doesn't assume
+// that both builds are equally noisy. At least two runs of each are needed to
+// estimate the variances
+NpsComparison CompareNps(const NpsSample &baseline, const NpsSample &current) {
+  NpsComparison comparison{
+      .change = (current.mean - baseline.mean) / std::max(baseline.mean, 1.0),
+      .t = std::nullopt,
+      .significant = false};
+  if (baseline.count < 2 || current.count < 2) return comparison;
+
+  const double baseline_error = baseline.variance / baseline.count;
+  const double current_error = current.variance / current.count;
+  const double standard_error = std::sqrt(baseline_error + current_error);
+  if (standard_error == 0) {
+    comparison.significant = baseline.mean != current.mean;
+    return comparison;
+  }
+
+  comparison.t = (current.mean - baseline.mean) / standard_error;
+
+  const double degrees_of_freedom =
+      std::pow(baseline_error + current_error, 2) /
+      (std::pow(baseline_error, 2) / (baseline.count - 1) +
+       std::pow(current_error, 2) / (current.count - 1));
+  comparison.significant =
+      std::abs(*comparison.t) > CriticalT(degrees_of_freedom);
+  return comparison;
+}
+
+NpsComparison PrintComparison(std::string_view name,
+                              const NpsSample &baseline,
+                              const NpsSample &current,
+                              std::string_view note) {
+  const auto comparison = CompareNps(baseline, current);
+
+  std::string verdict;
+  if (comparison.significant) {
+    verdict = comparison.change < 0 ? "regression" : "improvement";
+  }
+  if (!note.empty()) {
+    verdict += verdict.empty() ? note : fmt::format(" ({})", note);
+  }
+
+  fmt::println(
+      "{:>8} {:>10.0f} {:>9.0f} {:>10.0f} {:>9.0f} {:>+7.2f}% {:>6} {}",
+      name,
+      baseline.mean,
+      std::sqrt(baseline.variance),
+      current.mean,
+      std::sqrt(current.variance),
+      comparison.change * 100,
+      comparison.t ? fmt::format("{:.2f}", *comparison.t) : "n/a",
+      verdict);
+  return comparison;
+}
+
+void BenchCompareSuite(int depth, int runs, const std::string &path) {
+  const auto baseline = ReadBenchCsv(path);
+  if (!baseline) return;
+
+  const auto current = RunBenchRecords(depth, runs);
+
+  // Per-position NPS of every run, and the totals of every run
+  const auto group_nps = [](const std::vector<BenchRecord> &records) {
+    std::vector<std::vector<double>> positions(kBenchFens.size());
+    std::map<int, std::pair<U64, U64>> run_totals;
+    for (const auto &record : records) {
+      if (record.position >= 0 && record.position < std::ssize(kBenchFens)) {
+        positions[record.position].push_back(record.Nps());
+      }
+      run_totals[record.run].first += record.nodes;
+      run_totals[record.run].second += record.time;
+    }
+
+    std::vector<double> totals;
+    for (const auto &[run, total] : run_totals) {
+      totals.push_back(total.first * 1000.0 / std::max<U64>(total.second, 1));
+    }
+    return std::make_pair(positions, totals);
+  };
+
+  const auto [baseline_positions, baseline_totals] = group_nps(*baseline);
+  const auto [current_positions, current_totals] = group_nps(current);
+
+  // Different node counts mean that the search changed, so the NPS of the
+  // position isn't measured on the same tree
+  std::vector<std::string> notes(kBenchFens.size());
+  for (const auto &record : *baseline) {
+    if (record.run != 0 || record.position < 0 ||
+        record.position >= std::ssize(kBenchFens)) {
+      continue;
+    }
+    const auto &current_record = current[record.position];
+    if (record.fen != current_record.fen) {
+      notes[record.position] = "different fen";
+    } else if (record.nodes != current_record.nodes) {
+      notes[record.position] = "different nodes";
+    }
+  }
+
+  fmt::println("{:>8} {:>10} {:>9} {:>10} {:>9} {:>8} {:>6} {}",
+               "position",
+               "base nps",
+               "base sd",
+               "new nps",
+               "new sd",
+               "change",
+               "t",
+               "verdict");
+
+  int regressions = 0;
+  for (std::size_t i = 0; i < kBenchFens.size(); i++) {
+    const auto comparison = PrintComparison(std::to_string(i + 1),
+                                            SummarizeNps(baseline_positions[i]),
+                                            SummarizeNps(current_positions[i]),
+                                            notes[i]);
+    regressions += comparison.significant && comparison.change < 0;
+  }
+
+  PrintComparison("total",
+                  SummarizeNps(baseline_totals),
+                  SummarizeNps(current_totals),
+                  "");
+  fmt::println("{} of {} positions regressed significantly",
+               regressions,
+               kBenchFens.size());
+}
+
+// Runs the bench positions through the thread pool, doubling the thread count
+// up to the given one, and reports each count's speedup over a single thread.
+// At a fixed depth the speedup is in time to depth, otherwise in nodes per
+// second over the fixed time per position
+void ThreadedBenchSuite(int max_threads,
+                        int hash_mb,
+                        int move_time,
+                        int depth) {
+  fmt::println("starting threaded benchmark with {} MB hash at {}",
+               hash_mb,
+               move_time > 0 ? fmt::format("{} ms per position", move_time)
+                             : fmt::format("depth {}", depth));
+
+  Board board;
+  search::Search search(board);
+  search.ResizeHash(hash_mb);
+  search.SetPrintInfo(false);
+
+  std::vector<int> thread_counts;
+  for (int num_threads = 1; num_threads < max_threads; num_threads *= 2) {
+    thread_counts.push_back(num_threads);
+  }
+  thread_counts.push_back(max_threads);
+
+  double single_thread_nps = 0, single_thread_time = 0;
+  for (const int num_threads : thread_counts) {
+    search.SetThreadCount(num_threads);
+
+    U64 nodes = 0, elapsed = 0, depths = 0;
+    for (const auto &position : kBenchFens) {
+      board.SetFromFen(position);
+      search.NewGame();
+
+      if (move_time > 0) {
+        search.Start({.move_time = move_time});
+      } else {
+        search.Start({.depth = depth});
+      }
+      search.WaitForThreads();
+
+      nodes += search.GetNodesSearched();
+      elapsed += search.GetTimeManagement().TimeElapsed();
+      depths += search.GetCompletedDepth();
+    }
+
+    const double time = std::max<U64>(elapsed, 1);
+    const double nps = nodes * 1000 / time;
+    if (num_threads == 1) {
+      single_thread_nps = nps;
+      single_thread_time = time;
+    }
+
+    fmt::println(
+        "threads: {:3} time: {:7} ms nodes: {:11} nps: {:10} nps/thread: {:9} "
+        "avg depth: {:5.2f} speedup: {:5.2f}x",
+        num_threads,
+        elapsed,
+        nodes,
+        static_cast<U64>(nps),
+        static_cast<U64>(nps / num_threads),
+        static_cast<double>(depths) / kBenchFens.size(),
+        move_time > 0 ? nps / single_thread_nps : single_thread_time / time);
+  }
+
+  search.SetPrintInfo(true);
+}
+
+struct HistorySharing {
+  std::string_view name;
+  bool continuation, correction;
+};
+
+constexpr std::array kScalingThreadCounts = {1, 2, 4, 8, 16, 32, 64};
+
+constexpr std::array<HistorySharing, 4> kHistorySharingModes = {{
+    {"private", false, false},
+    {"continuation", true, false},
+    {"correction", false, true},
+    {"both", true, true},
+}};
+
+// Measures the time each thread count takes to reach the given depth on the
+// bench positions, with private or shared history tables
+void ScalingSuite(int depth) {
+  fmt::println("starting lazy smp scaling benchmark at depth {}", depth);
+
+  Board board;
+  search::Search search(board);
+  search.ResizeHash(64);
+  search.SetPrintInfo(false);
+
+  for (const int num_threads : kScalingThreadCounts) {
+    search.SetThreadCount(num_threads);
+
+    for (const auto &mode : kHistorySharingModes) {
+      search.ShareContinuationHistory(mode.continuation);
+      search.ShareCorrectionHistory(mode.correction);
+
+      U64 nodes = 0, elapsed = 0;
+      for (const auto &position : kBenchFens) {
+        board.SetFromFen(position);
+        search.NewGame();
+
+        search.Start({.depth = depth});
+        search.WaitForThreads();
+
+        nodes += search.GetNodesSearched();
+        elapsed += search.GetTimeManagement().TimeElapsed();
+      }
+
+      fmt::println(
+          "threads: {:2} shared: {:12} time: {:6} ms nodes: {:10} nps: {}",
+          num_threads,
+          mode.name,
+          elapsed,
+          nodes,
+          static_cast<U64>(nodes * 1000 / std::max<U64>(elapsed, 1)));
+    }
+  }
+
+  search.SetPrintInfo(true);
+}
+
+}  // namespace tests
@@ -0,0 +1,69 @@
+#include <filesystem>
+#include <optional>
+
+#include "../data_gen/data_gen.h"
+#include "../data_gen/format/binpack_reader.h"
+#include "tests.h"
+
+namespace tests {
+
+constexpr std::array kDataGenGameCounts = {1, 7, 24};
+constexpr int kDataGenThreads = 4;
+
+// Counts the whole games of a binpack file, or returns nothing if it ends in a
+// partial one
+std::optional<U64> CountGames(const std::string &path) {
+  const data_gen::format::BinPackFile file(path);
+  if (!file.IsOpen()) return std::nullopt;
+
+  data_gen::format::BinPackReader reader(file.Data(),
+                                         file.Data() + file.Size());
+  data_gen::format::BinPackGame game;
+  U64 games = 0;
+  while (reader.Next(game)) ++games;
+
+  if (reader.Remaining() > 0) return std::nullopt;
+  return games;
+}
+
+// Runs tiny datagen jobs on several threads with an opening filter that rejects
+// most starting positions, so that games are often given back while other
+// threads are claiming the last ones, and checks that every run still writes
+// exactly the games it was asked for
+void DataGenSuite() {
+  fmt::println("starting datagen game count test");
+
+  const auto prefix =
+      (std::filesystem::temp_directory_path() / "integral-datagen-test")
+          .string();
+
+  for (const int num_games : kDataGenGameCounts) {
+    const auto path = data_gen::Generate({
+        .soft_node_limit = 200,
+        .hard_node_limit = 1000,
+        .num_games = static_cast<U64>(num_games),
+        .num_threads = kDataGenThreads,
+        .min_move_plies = 8,
+        .max_move_plies = 9,
+        .output_file = prefix,
+        .verification_nodes = 2000,
+        .max_opening_score = 25,
+    });
+
+    const auto games = path.empty() ? std::nullopt : CountGames(path);
+    const bool passed = games == static_cast<U64>(num_games);
+    fmt::println("{}\033[0m {} threads, {} games: wrote {}",
+                 passed ? "\033[32mpassed" : "\033[31mfailed",
+                 kDataGenThreads,
+                 num_games,
+                 games ? std::to_string(*games) : "an unreadable file");
+
+    if (!path.empty()) {
+      std::error_code error;
+      std::filesystem::remove(path, error);
+      std::filesystem::remove(path + ".checkpoint", error);
+    }
+  }
+}
+
+}  // namespace tests
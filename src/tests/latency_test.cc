@@ -0,0 +1,58 @@
+#include <algorithm>
+#include <numeric>
+
+#include "../chess/board.h"
+#include "../engine/search/search.h"
+#include "tests.h"
+
+namespace tests {
+
+constexpr std::array kLatencyThreadCounts = {1, 16, 128};
+constexpr int kLatencySearches = 50;
+
+// Measures the round trip of a "go movetime 1" search, from waking up the
+// thread pool until every thread has finished and reported back, which is
+// dominated by the cost of starting and stopping the threads
+void LatencySuite() {
+  fmt::println("starting thread pool latency benchmark");
+
+  Board board;
+  board.SetFromFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+
+  search::Search search(board);
+  search.ResizeHash(16);
+  search.SetPrintInfo(false);
+
+  for (const int num_threads : kLatencyThreadCounts) {
+    search.SetThreadCount(num_threads);
+    search.NewGame();
+
+    std::vector<double> latencies;
+    for (int i = 0; i <= kLatencySearches; i++) {
+      const auto start_time = std::chrono::steady_clock::now();
+      search.Start({.move_time = 1});
+      search.WaitForThreads();
+      const auto elapsed = std::chrono::duration<double, std::micro>(
+          std::chrono::steady_clock::now() - start_time);
+
+      // The first search warms up the threads and is left out
+      if (i > 0) latencies.push_back(elapsed.count());
+    }
+
+    std::ranges::sort(latencies);
+    const double mean =
+        std::accumulate(latencies.begin(), latencies.end(), 0.0) /
+        latencies.size();
+
+    fmt::println(
+        "threads: {:3} mean: {:8.1f} us median: {:8.1f} us max: {:8.1f} us",
+        num_threads,
+        mean,
+        latencies[latencies.size() / 2],
+        latencies.back());
+  }
+
+  search.SetPrintInfo(true);
+}
+
+}  // namespace tests
@@ -1,5 +1,9 @@
+#include <atomic>
+#include <thread>
+
 #include "../chess/board.h"
 #include "../chess/move_gen.h"
+#include "../utils/hash_table.h"
 #include "tests.h"
 
 namespace tests {
@@ -146,20 +150,25 @@ template <PerftType type>
 U64 PertInternal(Board &board, int depth, int start_depth) {
   U64 total_nodes = 0;
 
-  auto moves = move_gen::GenerateMoves(MoveGenType::kAll, board);
+  auto moves = move_gen::GenerateLegalMoves(MoveGenType::kAll, board);
+
+  // Bulk counting: every generated move is legal, so there's no need to visit
+  // the leaves
+  if (type == PerftType::kNormal && depth == 1) {
+    return moves.Size();
+  }
+
   for (int i = 0; i < moves.Size(); i++) {
     const auto move = moves[i];
-    if (!board.IsMoveLegal(move)) continue;
 
     U64 child_nodes;
     if (depth == 1) {
-      // Bulk counting
       total_nodes += child_nodes = 1;
     } else {
-      board.MakeMove(move);
+      board.MakeMove<false>(move);
       total_nodes += child_nodes =
           PertInternal<PerftType::kNormal>(board, depth - 1, start_depth);
-      board.UndoMove();
+      board.UndoMove<false>();
     }
 
     if (type == PerftType::kSplit && depth == start_depth) {
@@ -185,11 +194,157 @@ void Perft(Board &board, int depth) {
       static_cast<U64>(nodes * 1000 / std::max<U64>(elapsed.count(), 1)));
 }
 
+// The key is stored xored with the data so that entries torn by concurrent
+// writes from other threads fail verification instead of returning garbage
+struct PerftEntry {
+  U64 key_xor_data = 0;
+  U64 data = 0;
+};
+
+class PerftTable : public AlignedHashTable<PerftEntry> {
+ public:
+  explicit PerftTable(std::size_t mb_size)
+      : AlignedHashTable<PerftEntry>(mb_size) {}
+
+  [[nodiscard]] std::optional<U64> Probe(U64 key, int depth) {
+    auto &entry = (*this)[key];
+    const U64 data =
+        std::atomic_ref<U64>(entry.data).load(std::memory_order_relaxed);
+    const U64 key_xor_data = std::atomic_ref<U64>(entry.key_xor_data)
+                                 .load(std::memory_order_relaxed);
+    if ((key_xor_data ^ data) != key || (data & 0xFF) != static_cast<U64>(depth)) {
+      return std::nullopt;
+    }
+    return data >> 8;
+  }
+
+  void Save(U64 key, int depth, U64 nodes) {
+    auto &entry = (*this)[key];
+    const U64 data = nodes << 8 | depth;
+    std::atomic_ref<U64>(entry.data).store(data, std::memory_order_relaxed);
+    std::atomic_ref<U64>(entry.key_xor_data)
+        .store(key ^ data, std::memory_order_relaxed);
+  }
+};
+
+U64 HashedPerft(Board &board, int depth, PerftTable *table) {
+  if (depth == 0) {
+    return 1;
+  }
+
+  auto moves = move_gen::GenerateLegalMoves(MoveGenType::kAll, board);
+  if (depth == 1) {
+    return moves.Size();
+  }
+
+  const U64 key = board.GetState().zobrist_key;
+  if (table) {
+    if (const auto nodes = table->Probe(key, depth)) {
+      return *nodes;
+    }
+  }
+
+  U64 total_nodes = 0;
+  for (int i = 0; i < moves.Size(); i++) {
+    board.MakeMove<false>(moves[i]);
+    total_nodes += HashedPerft(board, depth - 1, table);
+    board.UndoMove<false>();
+  }
+
+  if (table) {
+    table->Save(key, depth, total_nodes);
+  }
+
+  return total_nodes;
+}
+
+void ParallelPerft(Board &board, int depth, int num_threads, int hash_mb) {
+  assert(depth >= 1 && num_threads >= 1);
+
+  const auto start_time = std::chrono::steady_clock::now();
+
+  std::unique_ptr<PerftTable> table;
+  if (hash_mb > 0) {
+    table = std::make_unique<PerftTable>(hash_mb);
+  }
+
+  // Split the tree two plies deep when possible, since the root alone rarely
+  // has enough moves to keep every thread busy until the end
+  struct WorkItem {
+    int root_index;
+    Move reply;
+  };
+
+  auto root_moves = move_gen::GenerateLegalMoves(MoveGenType::kAll, board);
+  std::vector<WorkItem> work;
+  for (int i = 0; i < root_moves.Size(); i++) {
+    if (depth < 3) {
+      work.push_back({i, Move::NullMove()});
+      continue;
+    }
+
+    board.MakeMove<false>(root_moves[i]);
+    auto replies = move_gen::GenerateLegalMoves(MoveGenType::kAll, board);
+    for (int j = 0; j < replies.Size(); j++) {
+      work.push_back({i, replies[j]});
+    }
+    board.UndoMove<false>();
+  }
+
+  std::vector<std::atomic<U64>> root_nodes(root_moves.Size());
+  std::atomic<std::size_t> next_item = 0;
+
+  const auto worker = [&]() {
+    Board thread_board(board.GetState(), BoardMode::kMovesOnly);
+    while (true) {
+      const std::size_t index = next_item.fetch_add(1);
+      if (index >= work.size()) break;
+
+      const auto &item = work[index];
+      thread_board.MakeMove<false>(root_moves[item.root_index]);
+      U64 nodes;
+      if (item.reply) {
+        thread_board.MakeMove<false>(item.reply);
+        nodes = HashedPerft(thread_board, depth - 2, table.get());
+        thread_board.UndoMove<false>();
+      } else {
+        nodes = HashedPerft(thread_board, depth - 1, table.get());
+      }
+      thread_board.UndoMove<false>();
+
+      root_nodes[item.root_index] += nodes;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back(worker);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  U64 nodes = 0;
+  for (int i = 0; i < root_moves.Size(); i++) {
+    fmt::println("{}: {}", root_moves[i].ToString(), root_nodes[i].load());
+    nodes += root_nodes[i];
+  }
+
+  const auto elapsed = duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start_time);
+
+  fmt::println(
+      "info nodes {} time {} nps {}",
+      nodes,
+      elapsed.count(),
+      static_cast<U64>(nodes * 1000 / std::max<U64>(elapsed.count(), 1)));
+}
+
 void PerftSuite() {
   fmt::println("starting perft test");
   const auto start_time = std::chrono::steady_clock::now();
 
-  Board board;
+  Board board(BoardMode::kMovesOnly);
   for (const auto &perft_test : kPerftSuite) {
     const auto test_data = SplitString(perft_test, ';');
     board.SetFromFen(test_data[0]);
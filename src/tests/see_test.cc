@@ -84,7 +84,7 @@ void SEESuite() {
   fmt::println("starting see test");
   const auto start_time = std::chrono::steady_clock::now();
 
-  Board board;
+  Board board(BoardMode::kMovesOnly);
   for (const auto &see_test : kSEESuite) {
     const auto test_data = SplitString(see_test, '|');
     board.SetFromFen(test_data[0]);
@@ -0,0 +1,181 @@
+#include <memory>
+
+#include "../chess/board.h"
+#include "../chess/move_gen.h"
+#include "../magics/attacks.h"
+#include "tests.h"
+
+namespace tests {
+
+// Positions taken from the perft and SEE suites, used to harvest slider
+// lookups with realistic occupancies
+// clang-format off
+constexpr std::array kSliderPerftFens = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "R6r/8/8/2K5/5k2/8/8/r6R w - - 0 1",
+    "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N w - - 0 1",
+};
+
+constexpr std::array kSliderSEEFens = {
+    "6k1/1pp4p/p1pb4/6q1/3P1pRr/2P4P/PP1Br1P1/5RKN w - -",
+    "5rk1/1pp2q1p/p1pb4/8/3P1NP1/2P5/1P1BQ1P1/5RK1 b - -",
+    "2r1r1k1/pp1bppbp/3p1np1/q3P3/2P2P2/1P2B3/P1N1B1PP/2RQ1RK1 b - -",
+    "7r/5qpk/p1Qp1b1p/3r3n/BB3p2/5p2/P1P2P2/4RK1R w - -",
+    "6rr/6pk/p1Qp1b1p/2n5/1B3p2/5p2/P1P2P2/4RK1R w - -",
+    "7r/5qpk/2Qp1b1p/1N1r3n/BB3p2/5p2/P1P2P2/4RK1R w - -",
+    "6RR/4bP2/8/8/5r2/3K4/5p2/4k3 w - -",
+};
+// clang-format on
+
+struct SliderQuery {
+  Square square;
+  bool is_rook;
+  BitBoard occupied;
+};
+
+using SliderQueries = std::vector<SliderQuery>;
+
+void HarvestPerftQueries(Board &board, int depth, SliderQueries &queries) {
+  const auto &state = board.GetState();
+  const BitBoard occupied = state.Occupied();
+
+  for (Square square : state.Bishops() | state.Queens()) {
+    queries.push_back({square, false, occupied});
+  }
+  for (Square square : state.Rooks() | state.Queens()) {
+    queries.push_back({square, true, occupied});
+  }
+
+  if (depth == 0) return;
+
+  auto moves = move_gen::GenerateLegalMoves(MoveGenType::kAll, board);
+  for (int i = 0; i < moves.Size(); i++) {
+    board.MakeMove(moves[i]);
+    HarvestPerftQueries(board, depth - 1, queries);
+    board.UndoMove();
+  }
+}
+
+// Mimics the x-ray rescans done by eval::StaticExchange, where slider attacks
+// to the exchanged square are looked up again each time a piece is removed
+void HarvestSEEQueries(Board &board, SliderQueries &queries) {
+  const auto &state = board.GetState();
+
+  auto captures = move_gen::GenerateLegalMoves(MoveGenType::kNoisy, board);
+  for (int i = 0; i < captures.Size(); i++) {
+    const Square target = captures[i].GetTo();
+
+    BitBoard occupied = state.Occupied();
+    while (occupied) {
+      queries.push_back({target, false, occupied});
+      queries.push_back({target, true, occupied});
+      occupied.PopLsb();
+    }
+  }
+}
+
+template <typename Lookup>
+double TimeQueries(const SliderQueries &queries, Lookup lookup, U64 &checksum) {
+  constexpr int kIterations = 20;
+
+  const auto start_time = std::chrono::steady_clock::now();
+  for (int iteration = 0; iteration < kIterations; iteration++) {
+    for (const auto &query : queries) {
+      checksum ^= lookup(query).AsU64();
+    }
+  }
+  const auto elapsed = std::chrono::duration<double, std::nano>(
+      std::chrono::steady_clock::now() - start_time);
+
+  return elapsed.count() / (queries.size() * kIterations);
+}
+
+void CompareSliderLookups(std::string_view name,
+                          const SliderQueries &queries,
+                          const magics::attacks::BishopAttacksTable &bishops,
+                          const magics::attacks::RookAttacksTable &rooks) {
+  U64 magic_checksum = 0;
+  const double magic_ns = TimeQueries(
+      queries,
+      [&](const SliderQuery &query) {
+        return query.is_rook
+                 ? magics::attacks::RookMagicAttacks(
+                       query.square, query.occupied, rooks)
+                 : magics::attacks::BishopMagicAttacks(
+                       query.square, query.occupied, bishops);
+      },
+      magic_checksum);
+  fmt::println("{} lookups: {} magic: {:.2f} ns/lookup",
+               name,
+               queries.size(),
+               magic_ns);
+
+#ifdef INTEGRAL_PEXT_ATTACKS
+  U64 pext_checksum = 0;
+  const double pext_ns =
+      TimeQueries(queries,
+                  [](const SliderQuery &query) {
+                    return query.is_rook ? magics::attacks::RookPextAttacks(
+                                               query.square, query.occupied)
+                                         : magics::attacks::BishopPextAttacks(
+                                               query.square, query.occupied);
+                  },
+                  pext_checksum);
+  fmt::println("{} lookups: {} pext: {:.2f} ns/lookup ({:.2f}x) {}",
+               name,
+               queries.size(),
+               pext_ns,
+               magic_ns / pext_ns,
+               pext_checksum == magic_checksum ? "\033[32mmatching\033[0m"
+                                               : "\033[31mmismatch\033[0m");
+#endif
+}
+
+void SliderSuite() {
+  fmt::println("starting slider attack benchmark");
+
+#ifdef INTEGRAL_PEXT_ATTACKS
+  // PEXT builds don't keep the magic tables resident, so they are generated
+  // here just for the comparison
+  auto bishop_attacks =
+      std::make_unique<magics::attacks::BishopAttacksTable>();
+  auto rook_attacks = std::make_unique<magics::attacks::RookAttacksTable>();
+  magics::attacks::GenerateBishopAttacks(*bishop_attacks);
+  magics::attacks::GenerateRookAttacks(*rook_attacks);
+
+  const auto &bishops = *bishop_attacks;
+  const auto &rooks = *rook_attacks;
+
+  fmt::println("pext tables: {} KB, magic tables: {} KB",
+               (sizeof(magics::attacks::kBishopPextAttacks) +
+                sizeof(magics::attacks::kRookPextAttacks)) /
+                   1024,
+               (sizeof(bishops) + sizeof(rooks)) / 1024);
+#else
+  const auto &bishops = magics::attacks::kBishopAttacks;
+  const auto &rooks = magics::attacks::kRookAttacks;
+
+  fmt::println("pext attacks are unavailable in this build");
+#endif
+
+  Board board(BoardMode::kMovesOnly);
+
+  SliderQueries perft_queries;
+  for (const auto &fen : kSliderPerftFens) {
+    board.SetFromFen(fen);
+    HarvestPerftQueries(board, 3, perft_queries);
+  }
+
+  SliderQueries see_queries;
+  for (const auto &fen : kSliderSEEFens) {
+    board.SetFromFen(fen);
+    HarvestSEEQueries(board, see_queries);
+  }
+
+  CompareSliderLookups("perft", perft_queries, bishops, rooks);
+  CompareSliderLookups("see", see_queries, bishops, rooks);
+}
+
+}  // namespace tests
@@ -16,15 +16,47 @@ class Search;
 namespace tests {
 
 constexpr int kDefaultBenchDepth = 12;
+constexpr int kDefaultScalingDepth = 10;
+constexpr int kDefaultBenchRuns = 5;
 
 void BenchSuite(int depth);
 
+// Reports hardware counters per node for each bench position
+void BenchProfileSuite(int depth);
+
+// Writes the nodes, time, NPS, depth, best move and hashfull of each bench
+// position over a number of runs as CSV
+void BenchCsvSuite(int depth, int runs, const std::string &path);
+
+// Benches a number of times and flags the positions whose NPS is
+// significantly lower than in a CSV written by BenchCsvSuite
+void BenchCompareSuite(int depth, int runs, const std::string &path);
+
+// Benches through the thread pool at a fixed depth, or at a fixed time per
+// position when move_time is set
+void ThreadedBenchSuite(int max_threads, int hash_mb, int move_time, int depth);
+
+// Compares lazy SMP scaling with private and shared history tables
+void ScalingSuite(int depth);
+
 void SEESuite();
 
 void PerftSuite();
 
+void SliderSuite();
+
+void LatencySuite();
+
+// Checks that multi-threaded datagen runs write exactly the requested number
+// of games while most openings are rejected
+void DataGenSuite();
+
 void Perft(Board &board, int depth);
 
+// Splits the perft tree across threads, sharing a hash table of subtree node
+// counts of the given size (or none when it's zero)
+void ParallelPerft(Board &board, int depth, int num_threads, int hash_mb);
+
 }  // namespace tests
 
 #endif  // INTEGRAL_TESTS_H
\ No newline at end of file
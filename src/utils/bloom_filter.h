@@ -0,0 +1,68 @@
+#ifndef INTEGRAL_BLOOM_FILTER_H
+#define INTEGRAL_BLOOM_FILTER_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "types.h"
+
+// Set of 64-bit keys that fits in a fixed amount of memory, at the cost of
+// sometimes claiming to hold a key it was never given. The keys are expected
+// to be random already, like zobrist keys, so they aren't hashed again
+class BloomFilter {
+ public:
+  // Picks the number of probes that gives the fewest false positives once
+  // expected_keys keys have been inserted
+  BloomFilter(U64 size_bytes, U64 expected_keys)
+      : bits_(std::max<U64>(size_bytes / sizeof(U64), 1)) {
+    const double bits_per_key = static_cast<double>(NumBits()) /
+                                std::max<U64>(expected_keys, 1);
+    num_probes_ = std::clamp(
+        static_cast<int>(std::round(bits_per_key * std::log(2.0))), 1, 16);
+  }
+
+  // Inserts the key, returning whether it (probably) was already present
+  bool Insert(U64 key) {
+    // Double hashing derives every probe from two halves of the key
+    const U64 step = ((key >> 32) | (key << 32)) | 1;
+
+    bool present = true;
+    for (int i = 0; i < num_probes_; i++) {
+      const U64 bit = Reduce(key + i * step);
+      U64 &word = bits_[bit / 64];
+      const U64 mask = 1ULL << (bit % 64);
+      present &= (word & mask) != 0;
+      word |= mask;
+    }
+    return present;
+  }
+
+  // Chance that a key that was never inserted is reported as present
+  [[nodiscard]] double FalsePositiveRate(U64 inserted_keys) const {
+    return std::pow(
+        1.0 - std::exp(-static_cast<double>(num_probes_) * inserted_keys /
+                       NumBits()),
+        num_probes_);
+  }
+
+  [[nodiscard]] int NumProbes() const {
+    return num_probes_;
+  }
+
+ private:
+  [[nodiscard]] U64 NumBits() const {
+    return bits_.size() * 64;
+  }
+
+  // Maps a hash onto a bit without a division
+  [[nodiscard]] U64 Reduce(U64 hash) const {
+    return static_cast<U64>((static_cast<U128>(hash) * NumBits()) >> 64);
+  }
+
+ private:
+  std::vector<U64> bits_;
+  int num_probes_;
+};
+
+#endif  // INTEGRAL_BLOOM_FILTER_H
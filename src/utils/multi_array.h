@@ -2,6 +2,8 @@
 #define INTEGRAL_MULTI_ARRAY_H
 
 #include <array>
+#include <cstring>
+#include <type_traits>
 
 template <typename T, std::size_t N, std::size_t... Ns>
 struct MultiArrayImpl {
@@ -16,4 +18,12 @@ struct MultiArrayImpl<T, N> {
 template <typename T, std::size_t... Ns>
 using MultiArray = typename MultiArrayImpl<T, Ns...>::Type;
 
+// Zeroes every element in place, since the nested arrays are contiguous this
+// is a single (vectorized) memset
+template <typename Array>
+void ClearMultiArray(Array &array) {
+  static_assert(std::is_trivially_copyable_v<Array>);
+  std::memset(&array, 0, sizeof(Array));
+}
+
 #endif  // INTEGRAL_MULTI_ARRAY_H
\ No newline at end of file
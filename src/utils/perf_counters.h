@@ -0,0 +1,172 @@
+#ifndef INTEGRAL_PERF_COUNTERS_H
+#define INTEGRAL_PERF_COUNTERS_H
+
+#include <array>
+#include <optional>
+#include <string_view>
+
+#include "types.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#endif
+
+enum class PerfCounter : U8 {
+  kCycles,
+  kInstructions,
+  kL1DMisses,
+  kLLCMisses,
+  kBranchMisses,
+  kDTLBMisses,
+  kNumCounters
+};
+
+constexpr std::size_t kNumPerfCounters =
+    static_cast<std::size_t>(PerfCounter::kNumCounters);
+
+constexpr std::array<std::string_view, kNumPerfCounters> kPerfCounterNames = {
+    "cycles",
+    "instructions",
+    "l1d-miss",
+    "llc-miss",
+    "branch-miss",
+    "dtlb-miss"};
+
+// Hardware counters for the calling thread, read through perf_event_open.
+// Counters the kernel or CPU doesn't support (or any counter outside of Linux)
+// are left unavailable rather than failing the whole set
+class PerfCounters {
+ public:
+  using Values = std::array<std::optional<U64>, kNumPerfCounters>;
+
+  PerfCounters() {
+    file_descriptors_.fill(-1);
+#if defined(__linux__)
+    for (std::size_t i = 0; i < kNumPerfCounters; i++) {
+      file_descriptors_[i] = Open(static_cast<PerfCounter>(i));
+    }
+#endif
+  }
+
+  ~PerfCounters() {
+#if defined(__linux__)
+    for (const int fd : file_descriptors_) {
+      if (fd != -1) close(fd);
+    }
+#endif
+  }
+
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  [[nodiscard]] bool IsAvailable(PerfCounter counter) const {
+    return file_descriptors_[static_cast<std::size_t>(counter)] != -1;
+  }
+
+  [[nodiscard]] bool AnyAvailable() const {
+    for (std::size_t i = 0; i < kNumPerfCounters; i++) {
+      if (IsAvailable(static_cast<PerfCounter>(i))) return true;
+    }
+    return false;
+  }
+
+  // Resets and starts every available counter
+  void Start() {
+#if defined(__linux__)
+    for (const int fd : file_descriptors_) {
+      if (fd == -1) continue;
+      ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  // Stops the counters and returns their values since Start(), scaled up when
+  // the kernel had to multiplex them with other events
+  Values Stop() {
+    Values values;
+#if defined(__linux__)
+    for (const int fd : file_descriptors_) {
+      if (fd != -1) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+
+    for (std::size_t i = 0; i < kNumPerfCounters; i++) {
+      const int fd = file_descriptors_[i];
+
+      // Laid out according to the read format chosen in Open()
+      struct {
+        U64 value, time_enabled, time_running;
+      } result;
+      if (fd == -1 || read(fd, &result, sizeof(result)) != sizeof(result) ||
+          result.time_running == 0) {
+        continue;
+      }
+
+      values[i] = static_cast<U64>(static_cast<double>(result.value) *
+                                   result.time_enabled / result.time_running);
+    }
+#endif
+    return values;
+  }
+
+ private:
+#if defined(__linux__)
+  static int Open(PerfCounter counter) {
+    perf_event_attr attributes;
+    std::memset(&attributes, 0, sizeof(attributes));
+    attributes.size = sizeof(attributes);
+    attributes.disabled = 1;
+    // Only user space is counted, which unprivileged processes are allowed to
+    // do at the default perf_event_paranoid level
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    attributes.read_format =
+        PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    constexpr auto kCacheReadMiss = (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    switch (counter) {
+      case PerfCounter::kCycles:
+        attributes.type = PERF_TYPE_HARDWARE;
+        attributes.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+      case PerfCounter::kInstructions:
+        attributes.type = PERF_TYPE_HARDWARE;
+        attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+      case PerfCounter::kL1DMisses:
+        attributes.type = PERF_TYPE_HW_CACHE;
+        attributes.config = PERF_COUNT_HW_CACHE_L1D | kCacheReadMiss;
+        break;
+      case PerfCounter::kLLCMisses:
+        attributes.type = PERF_TYPE_HW_CACHE;
+        attributes.config = PERF_COUNT_HW_CACHE_LL | kCacheReadMiss;
+        break;
+      case PerfCounter::kBranchMisses:
+        attributes.type = PERF_TYPE_HARDWARE;
+        attributes.config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+      case PerfCounter::kDTLBMisses:
+        attributes.type = PERF_TYPE_HW_CACHE;
+        attributes.config = PERF_COUNT_HW_CACHE_DTLB | kCacheReadMiss;
+        break;
+      default:
+        return -1;
+    }
+
+    // Counts the calling thread on whichever CPU it runs
+    return static_cast<int>(
+        syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+  }
+#endif
+
+ private:
+  std::array<int, kNumPerfCounters> file_descriptors_;
+};
+
+#endif  // INTEGRAL_PERF_COUNTERS_H
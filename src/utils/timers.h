@@ -0,0 +1,199 @@
+#ifndef INTEGRAL_TIMERS_H
+#define INTEGRAL_TIMERS_H
+
+// Scoped timers that attribute time spent in search to its subsystems. They
+// are only compiled in when INTEGRAL_TIMERS is defined (BUILD_TIMERS=ON in
+// CMake) and otherwise expand to nothing
+
+#ifdef INTEGRAL_TIMERS
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+#endif
+
+#include "types.h"
+
+namespace timers {
+
+enum class Timer : U8 {
+  kEvaluate,
+  kAccumulatorMakeMove,
+  kBoardMakeMove,
+  kCalculateThreats,
+  kMovePickerNext,
+  kTTProbe,
+  kStaticExchange,
+  kNumTimers
+};
+
+#ifdef INTEGRAL_TIMERS
+
+constexpr std::size_t kNumTimers = static_cast<std::size_t>(Timer::kNumTimers);
+
+constexpr std::array<std::string_view, kNumTimers> kTimerNames = {
+    "nnue::Evaluate",
+    "Accumulator::MakeMove",
+    "Board::MakeMove",
+    "Board::CalculateThreats",
+    "MovePicker::Next",
+    "TranspositionTable::Probe",
+    "eval::StaticExchange"};
+
+inline U64 ReadCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+struct TimerTotals {
+  std::array<U64, kNumTimers> cycles{};
+  std::array<U64, kNumTimers> calls{};
+};
+
+// Every thread accumulates into its own totals, which are only summed up when
+// the breakdown is printed so that the hot path never shares a cache line
+class TimerRegistry {
+ public:
+  void Register(TimerTotals *totals) {
+    std::lock_guard lock(mutex_);
+    thread_totals_.push_back(totals);
+  }
+
+  // Keeps the totals of threads that exit before the breakdown is printed
+  void Unregister(TimerTotals *totals) {
+    std::lock_guard lock(mutex_);
+    for (std::size_t i = 0; i < kNumTimers; i++) {
+      retired_totals_.cycles[i] += totals->cycles[i];
+      retired_totals_.calls[i] += totals->calls[i];
+    }
+    std::erase(thread_totals_, totals);
+  }
+
+  void Reset() {
+    std::lock_guard lock(mutex_);
+    retired_totals_ = {};
+    for (auto totals : thread_totals_) {
+      *totals = {};
+    }
+    start_cycles_ = ReadCycles();
+  }
+
+  void Print() {
+    std::lock_guard lock(mutex_);
+    TimerTotals sum = retired_totals_;
+    for (const auto totals : thread_totals_) {
+      for (std::size_t i = 0; i < kNumTimers; i++) {
+        sum.cycles[i] += totals->cycles[i];
+        sum.calls[i] += totals->calls[i];
+      }
+    }
+
+    // Timers nest (Board::MakeMove includes Accumulator::MakeMove) and
+    // threads overlap, so the shares are of one thread's elapsed cycles and
+    // don't add up to 100%
+    const U64 elapsed = std::max<U64>(ReadCycles() - start_cycles_, 1);
+    fmt::println("{:26} {:>12} {:>10} {:>12} {:>7}",
+                 "timer",
+                 "calls",
+                 "Mcycles",
+                 "cycles/call",
+                 "share");
+    for (std::size_t i = 0; i < kNumTimers; i++) {
+      fmt::println("{:26} {:>12} {:>10} {:>12.1f} {:>6.1f}%",
+                   kTimerNames[i],
+                   sum.calls[i],
+                   sum.cycles[i] / 1000000,
+                   static_cast<double>(sum.cycles[i]) /
+                       std::max<U64>(sum.calls[i], 1),
+                   100.0 * sum.cycles[i] / elapsed);
+    }
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<TimerTotals *> thread_totals_;
+  TimerTotals retired_totals_;
+  U64 start_cycles_ = 0;
+};
+
+// Constant initialized, since threads may register before dynamic
+// initialization of globals has finished
+constinit inline TimerRegistry registry;
+
+class ThreadTimerTotals {
+ public:
+  ThreadTimerTotals() {
+    registry.Register(&totals_);
+  }
+
+  ~ThreadTimerTotals() {
+    registry.Unregister(&totals_);
+  }
+
+  TimerTotals &Get() {
+    return totals_;
+  }
+
+ private:
+  TimerTotals totals_;
+};
+
+inline thread_local ThreadTimerTotals thread_totals;
+
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(Timer timer) : timer_(timer), start_(ReadCycles()) {}
+
+  ~ScopedTimer() {
+    auto &totals = thread_totals.Get();
+    const auto index = static_cast<std::size_t>(timer_);
+    totals.cycles[index] += ReadCycles() - start_;
+    ++totals.calls[index];
+  }
+
+ private:
+  Timer timer_;
+  U64 start_;
+};
+
+// Clears every thread's totals and restarts the elapsed cycle count
+inline void Reset() {
+  registry.Reset();
+}
+
+// Prints the breakdown accumulated by all threads since the last Reset()
+inline void Print() {
+  registry.Print();
+}
+
+#define INTEGRAL_TIMER_CONCAT_INNER(a, b) a##b
+#define INTEGRAL_TIMER_CONCAT(a, b) INTEGRAL_TIMER_CONCAT_INNER(a, b)
+#define SCOPED_TIMER(timer)                                             \
+  const timers::ScopedTimer INTEGRAL_TIMER_CONCAT(scoped_timer_, __LINE__)( \
+      timers::Timer::timer)
+
+#else
+
+inline void Reset() {}
+
+inline void Print() {}
+
+#define SCOPED_TIMER(timer)
+
+#endif
+
+}  // namespace timers
+
+#endif  // INTEGRAL_TIMERS_H
@@ -0,0 +1,213 @@
+/*
+ * lz4block - a small, dependency free implementation of the LZ4 block format
+ */
+
+#include "lz4block.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define MIN_MATCH 4
+/* The last match must start at least this many bytes before the end */
+#define MF_LIMIT 12
+/* The last bytes of a block are always literals */
+#define LAST_LITERALS 5
+#define MAX_DISTANCE 65535
+#define HASH_LOG 14
+
+static uint32_t read32(const uint8_t *p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+static uint32_t hash32(uint32_t sequence) {
+  return (sequence * 2654435761U) >> (32 - HASH_LOG);
+}
+
+/* Writes the part of a length that doesn't fit into its token nibble */
+static uint8_t *write_length(uint8_t *op, size_t length) {
+  while (length >= 255) {
+    *op++ = 255;
+    length -= 255;
+  }
+  *op++ = (uint8_t)length;
+  return op;
+}
+
+int lz4block_compress_bound(int src_size) {
+  if (src_size < 0) return 0;
+  return src_size + src_size / 255 + 16;
+}
+
+int lz4block_compress(const char *src,
+                      char *dst,
+                      int src_size,
+                      int dst_capacity) {
+  /* Offsets of the last position seen with each hash */
+  uint32_t table[1 << HASH_LOG];
+
+  const uint8_t *const base = (const uint8_t *)src;
+  const uint8_t *const iend = base + src_size;
+  const uint8_t *const mf_limit = iend - MF_LIMIT;
+  const uint8_t *const match_limit = iend - LAST_LITERALS;
+  const uint8_t *ip = base;
+  const uint8_t *anchor = base;
+
+  uint8_t *op = (uint8_t *)dst;
+  uint8_t *const oend = op + dst_capacity;
+
+  size_t literals;
+
+  if (src_size < 0) return 0;
+  memset(table, 0, sizeof(table));
+
+  if (src_size > MF_LIMIT) {
+    while (ip < mf_limit) {
+      const uint32_t sequence = read32(ip);
+      const uint32_t h = hash32(sequence);
+      const uint8_t *match = base + table[h];
+      const uint8_t *match_end;
+      size_t match_length;
+      uint8_t *token;
+
+      table[h] = (uint32_t)(ip - base);
+
+      if (match >= ip || ip - match > MAX_DISTANCE ||
+          read32(match) != sequence) {
+        /* Skip ahead faster the longer nothing has matched */
+        ip += 1 + ((ip - anchor) >> 6);
+        continue;
+      }
+
+      while (ip > anchor && match > base && ip[-1] == match[-1]) {
+        --ip;
+        --match;
+      }
+
+      match_end = ip + MIN_MATCH;
+      while (match_end < match_limit &&
+             *match_end == match[match_end - ip]) {
+        ++match_end;
+      }
+
+      literals = ip - anchor;
+      match_length = match_end - ip - MIN_MATCH;
+
+      if ((size_t)(oend - op) <
+          1 + literals + literals / 255 + 1 + 2 + match_length / 255 + 1) {
+        return 0;
+      }
+
+      token = op++;
+      if (literals >= 15) {
+        *token = 15 << 4;
+        op = write_length(op, literals - 15);
+      } else {
+        *token = (uint8_t)(literals << 4);
+      }
+      memcpy(op, anchor, literals);
+      op += literals;
+
+      *op++ = (uint8_t)((ip - match) & 0xFF);
+      *op++ = (uint8_t)((ip - match) >> 8);
+
+      if (match_length >= 15) {
+        *token |= 15;
+        op = write_length(op, match_length - 15);
+      } else {
+        *token |= (uint8_t)match_length;
+      }
+
+      ip = anchor = match_end;
+
+      /* Seeds the table inside the match, which finds the next one sooner */
+      if (ip < mf_limit) {
+        table[hash32(read32(ip - 2))] = (uint32_t)(ip - 2 - base);
+      }
+    }
+  }
+
+  literals = iend - anchor;
+  if ((size_t)(oend - op) < 1 + literals + literals / 255 + 1) return 0;
+
+  if (literals >= 15) {
+    *op++ = 15 << 4;
+    op = write_length(op, literals - 15);
+  } else {
+    *op++ = (uint8_t)(literals << 4);
+  }
+  memcpy(op, anchor, literals);
+  op += literals;
+
+  return (int)(op - (uint8_t *)dst);
+}
+
+/* Reads the extra bytes of a length, returning 0 if the input runs out */
+static int read_length(const uint8_t **ip,
+                       const uint8_t *iend,
+                       size_t *length) {
+  uint8_t byte;
+  do {
+    if (*ip >= iend) return 0;
+    byte = *(*ip)++;
+    *length += byte;
+  } while (byte == 255);
+  return 1;
+}
+
+int lz4block_decompress(const char *src,
+                        char *dst,
+                        int src_size,
+                        int dst_capacity) {
+  const uint8_t *ip = (const uint8_t *)src;
+  const uint8_t *const iend = ip + src_size;
+  uint8_t *op = (uint8_t *)dst;
+  uint8_t *const ostart = op;
+  uint8_t *const oend = op + dst_capacity;
+
+  if (src_size <= 0 || dst_capacity < 0) return -1;
+
+  while (1) {
+    const uint8_t token = *ip++;
+    size_t literals = token >> 4;
+    size_t match_length = token & 15;
+    size_t offset;
+    const uint8_t *match;
+
+    if (literals == 15 && !read_length(&ip, iend, &literals)) return -1;
+    if (literals > (size_t)(iend - ip) || literals > (size_t)(oend - op)) {
+      return -1;
+    }
+    memcpy(op, ip, literals);
+    ip += literals;
+    op += literals;
+
+    /* Only the last sequence has no match */
+    if (ip == iend) break;
+
+    if (iend - ip < 2) return -1;
+    offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > (size_t)(op - ostart)) return -1;
+
+    if (match_length == 15 && !read_length(&ip, iend, &match_length)) {
+      return -1;
+    }
+    match_length += MIN_MATCH;
+    if (match_length > (size_t)(oend - op)) return -1;
+
+    match = op - offset;
+    if (offset >= match_length) {
+      memcpy(op, match, match_length);
+      op += match_length;
+    } else {
+      /* Overlapping matches repeat the last offset bytes */
+      while (match_length--) *op++ = *match++;
+    }
+
+    if (ip >= iend) return -1;
+  }
+
+  return (int)(op - ostart);
+}
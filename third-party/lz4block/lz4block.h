@@ -0,0 +1,42 @@
+/*
+ * lz4block - a small, dependency free implementation of the LZ4 block format
+ *
+ * Blocks produced here can be decoded by any LZ4 block decoder
+ * (LZ4_decompress_safe) and vice versa. Only the block format is implemented,
+ * framing is left to the caller.
+ */
+
+#ifndef LZ4BLOCK_H
+#define LZ4BLOCK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Largest compressed size of an input of the given size */
+int lz4block_compress_bound(int src_size);
+
+/*
+ * Compresses src into dst, returning the compressed size, or 0 if it doesn't
+ * fit into dst_capacity bytes
+ */
+int lz4block_compress(const char *src,
+                      char *dst,
+                      int src_size,
+                      int dst_capacity);
+
+/*
+ * Decompresses a whole block, returning the decompressed size, or -1 if the
+ * block is malformed or doesn't fit into dst_capacity bytes. Never reads or
+ * writes out of bounds, whatever the input
+ */
+int lz4block_decompress(const char *src,
+                        char *dst,
+                        int src_size,
+                        int dst_capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LZ4BLOCK_H */